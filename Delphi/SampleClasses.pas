@@ -85,6 +85,56 @@ type
     function Get5: integer;
   end;
 
+  //deep class hierarchy (used by benchmark/delphi/class-hierarchy.js)
+  TDeepLevel0 = class
+  private
+    FValue0: integer;
+  public
+    function Level: integer; virtual;
+    function Base: integer;
+    property Value0: integer read FValue0 write FValue0;
+  end;
+
+  TDeepLevel1 = class(TDeepLevel0)
+  private
+    FValue1: integer;
+  public
+    function Level: integer; override;
+    property Value1: integer read FValue1 write FValue1;
+  end;
+
+  TDeepLevel2 = class(TDeepLevel1)
+  private
+    FValue2: integer;
+  public
+    function Level: integer; override;
+    property Value2: integer read FValue2 write FValue2;
+  end;
+
+  TDeepLevel3 = class(TDeepLevel2)
+  private
+    FValue3: integer;
+  public
+    function Level: integer; override;
+    property Value3: integer read FValue3 write FValue3;
+  end;
+
+  TDeepLevel4 = class(TDeepLevel3)
+  private
+    FValue4: integer;
+  public
+    function Level: integer; override;
+    property Value4: integer read FValue4 write FValue4;
+  end;
+
+  TDeepLevel5 = class(TDeepLevel4)
+  private
+    FValue5: integer;
+  public
+    function Level: integer; override;
+    property Value5: integer read FValue5 write FValue5;
+  end;
+
   TGlobalNamespace = class
   private
     FEng: TJSEngine;
@@ -114,8 +164,18 @@ type
     function NewAttrObject: TSomeAttrObject;
     [TGCAttr]
     function NewForbiddenObject: TSomeForbiddenObject;
+    [TGCAttr]
+    function NewDeepObject(level: integer): TDeepLevel0;
+    [TGCAttr]
+    function NewDeepLeaf: TDeepLevel5;
     function NewCOMObject(const className: string): IDispatch;
     function VLength(vec: TVector3): double;
+    function SumValues(a, b, c, d: TSomeObject): double;
+    //coordinates' arrays (used by benchmark/delphi/typed-arrays.js)
+    function MakeCoords(count: integer): TArray<Double>;
+    [TTypedArrayAttr]
+    function MakeTypedCoords(count: integer): TArray<Double>;
+    function SumCoords(const coords: TArray<Double>): double;
   end;
 
 implementation
@@ -196,6 +256,53 @@ begin
   Result := 5;
 end;
 
+{ TDeepLevel0 }
+
+function TDeepLevel0.Base: integer;
+begin
+  Result := FValue0;
+end;
+
+function TDeepLevel0.Level: integer;
+begin
+  Result := 0;
+end;
+
+{ TDeepLevel1 }
+
+function TDeepLevel1.Level: integer;
+begin
+  Result := 1;
+end;
+
+{ TDeepLevel2 }
+
+function TDeepLevel2.Level: integer;
+begin
+  Result := 2;
+end;
+
+{ TDeepLevel3 }
+
+function TDeepLevel3.Level: integer;
+begin
+  Result := 3;
+end;
+
+{ TDeepLevel4 }
+
+function TDeepLevel4.Level: integer;
+begin
+  Result := 4;
+end;
+
+{ TDeepLevel5 }
+
+function TDeepLevel5.Level: integer;
+begin
+  Result := 5;
+end;
+
 { TGlobalNamespace }
 
 procedure TGlobalNamespace.alert(str: string);
@@ -261,6 +368,23 @@ begin
   Result := TSomeForbiddenObject.Create;
 end;
 
+function TGlobalNamespace.NewDeepObject(level: integer): TDeepLevel0;
+begin
+  case level of
+    0: Result := TDeepLevel0.Create;
+    1: Result := TDeepLevel1.Create;
+    2: Result := TDeepLevel2.Create;
+    3: Result := TDeepLevel3.Create;
+    4: Result := TDeepLevel4.Create;
+    else Result := TDeepLevel5.Create;
+  end;
+end;
+
+function TGlobalNamespace.NewDeepLeaf: TDeepLevel5;
+begin
+  Result := TDeepLevel5.Create;
+end;
+
 function TGlobalNamespace.NewSomeChild: TSomeChild;
 begin
   Result := TSomeChild.Create;
@@ -276,6 +400,34 @@ begin
   Result := TSomeObject.Create;
 end;
 
+function TGlobalNamespace.MakeCoords(count: integer): TArray<Double>;
+var
+  i: integer;
+begin
+  SetLength(Result, count);
+  for i := 0 to count - 1 do
+    Result[i] := i;
+end;
+
+function TGlobalNamespace.MakeTypedCoords(count: integer): TArray<Double>;
+begin
+  Result := MakeCoords(count);
+end;
+
+function TGlobalNamespace.SumCoords(const coords: TArray<Double>): double;
+var
+  i: integer;
+begin
+  Result := 0;
+  for i := 0 to Length(coords) - 1 do
+    Result := Result + coords[i];
+end;
+
+function TGlobalNamespace.SumValues(a, b, c, d: TSomeObject): double;
+begin
+  Result := a.Value + b.Value + c.Value + d.Value;
+end;
+
 function TGlobalNamespace.VLength(vec: TVector3): double;
 begin
   Result := vec.Length;
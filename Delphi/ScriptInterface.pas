@@ -20,6 +20,8 @@ type
   TCallBackFuncAttr = class(TCustomAttribute);
 
   TCallBackPropAttr = class(TCustomAttribute);
+  //attribute for methods, which return TArray<Double>/TArray<Integer> as typed array
+  TTypedArrayAttr = class(TCustomAttribute);
 
   TAttrClass = class of TCustomAttribute;
 {\ATTRIBUTES}
@@ -53,6 +53,7 @@ type
   function DefaultTValue(typ: TRttiType): TValue;
   function JSArrayToTValue(val: IValuesArray): TValue; overload;
   function JSArrayToTValue(val: IValuesArray; typ: PTypeInfo): TValue; overload;
+  function JSTypedArrayToTValue(val: jsval; typ: PTypeInfo; out res: TValue): boolean;
 
   function JSValIsObject(v: jsval): Boolean;
 //  function JSValIsObjectClass(v: jsval; cl: TClass): Boolean;
@@ -71,12 +72,16 @@ type
     resArray: IValuesArray; Eng: IEngine; IntfList: IInterfaceList): boolean;
   function TValueToArray(val: TValue; Eng: IEngine;
     IntfList: IInterfaceList): IValuesArray;
+  function TValueToTypedArray(val: TValue; Eng: IEngine): IValue;
   function TryAsJSCallback(val: TValue; RecDescr: TRttiType;
     out jsVal: IBaseValue): Boolean;
   function TValueToJSRecord(recVal: TValue; Eng: IEngine;
     IntfList: IInterfaceList; RecDescr: TRttiType = nil): IBaseValue;
 
   function PUtf8CharToString(s: PAnsiChar): string;
+  //strings are passed as UTF-16 without conversion to UTF-8 and back
+  function JSValToUnicode(val: jsval): UnicodeString;
+  function UnicodeToJSValue(const s: UnicodeString; Eng: IEngine): IValue;
 
   function TypeHasAttribute(typ: TRttiType; attrClass: TAttrClass): boolean;
   function HasAttribute(member: TRttiMember; attrClass: TAttrClass): boolean;
@@ -135,7 +140,8 @@ begin
   inherited Create;
   if not val.IsV8Function then
     raise EScriptEngineException.Create('Value assigned to callback is not function');
-  Make(val);
+  //callback's args are reused by engine, so value should be detached to keep it
+  Make(val.Detach);
 end;
 
 destructor TJSValueRef.Destroy;
@@ -231,7 +237,7 @@ end;
   function JSValToString(val: jsval): UnicodeString;
   begin
     if val.IsString then
-      result := UTF8ToUnicodeString(RawByteString(val.AsString))
+      result := JSValToUnicode(val)
     else
       try
         raise Exception.Create('val is not string');
@@ -269,6 +275,34 @@ end;
     Result := TValue.FromArray(typ, TValueArr);
   end;
 
+  function JSTypedArrayToTValue(val: jsval; typ: PTypeInfo; out res: TValue): boolean;
+  var
+    data: Pointer;
+    len: NativeUInt;
+    kind: integer;
+    DoubleArr: TArray<Double>;
+    IntArr: TArray<Integer>;
+  begin
+    Result := False;
+    kind := val.AsTypedArray(data, len);
+    if (kind = TYPED_ARRAY_FLOAT64) and (typ = TypeInfo(TArray<Double>)) then
+    begin
+      SetLength(DoubleArr, len);
+      if len > 0 then
+        Move(data^, DoubleArr[0], len * SizeOf(Double));
+      res := TValue.From<TArray<Double>>(DoubleArr);
+      Result := True;
+    end
+    else if (kind = TYPED_ARRAY_INT32) and (typ = TypeInfo(TArray<Integer>)) then
+    begin
+      SetLength(IntArr, len);
+      if len > 0 then
+        Move(data^, IntArr[0], len * SizeOf(Integer));
+      res := TValue.From<TArray<Integer>>(IntArr);
+      Result := True;
+    end;
+  end;
+
   function JsValToVariant(val: jsval): Variant;
   begin
     if not assigned(val) then
@@ -375,7 +409,6 @@ end;
   function JsValToTValue(val: jsval; typ: TRttiType): TValue; overload;
   var
     TypeKind: TypInfo.TTypeKind;
-    str1: RawByteString;
     obj: IObject;
   begin
     Result := TValue.Empty;
@@ -388,7 +421,7 @@ end;
       tkChar: Result := string(val.AsString);
       tkEnumeration: Result := TValue.FromOrdinal(typ.Handle, val.AsInt);
       tkFloat: Result := val.AsNumber;
-      tkString: Result := UTF8ToUnicodeString(RawByteString(val.AsString));
+      tkString: Result := JSValToUnicode(val);
       tkSet: ;
       tkClass:
       begin
@@ -399,9 +432,9 @@ end;
           Result := nil;
       end;
       tkMethod: ;
-      tkWChar: Result := UTF8ToUnicodeString(RawByteString(val.AsString));
-      tkLString: Result := (UTF8ToUnicodeString(RawByteString(val.AsString)));
-      tkWString: Result := UTF8ToUnicodeString(RawByteString(val.AsString));
+      tkWChar: Result := JSValToUnicode(val);
+      tkLString: Result := JSValToUnicode(val);
+      tkWString: Result := JSValToUnicode(val);
       tkVariant: Result := TValue.From<Variant>(JsValToVariant(val));
       tkArray: Result := JSArrayToTValue(val.AsArray, typ.Handle);
       tkRecord:
@@ -413,13 +446,11 @@ end;
       end;
       tkInterface: ;
       tkInt64: Result := JSValToInt(val);
-      tkDynArray: Result := JSArrayToTValue(val.AsArray, typ.Handle);
+      tkDynArray:
+        if not JSTypedArrayToTValue(val, typ.Handle, Result) then
+          Result := JSArrayToTValue(val.AsArray, typ.Handle);
 
-      tkUString:
-      begin
-        str1 := RawByteString(val.AsString);
-        Result := UTF8ToUnicodeString(str1);
-      end;
+      tkUString: Result := JSValToUnicode(val);
       tkClassRef: ;
       tkPointer: ;
       tkProcedure: ;
@@ -550,20 +581,20 @@ end;
           Result := Eng.NewValue(val.AsOrdinal);
       end;
       tkFloat: Result := Eng.NewValue(val.AsExtended);
-      tkString: Result := Eng.NewValue(PAnsiChar(Utf8String(val.AsString)));
+      tkString: Result := UnicodeToJSValue(val.AsString, Eng);
       tkSet: ;
       tkClass: Result := MakeObject;
       tkMethod: ;
-      tkWChar: Result := Eng.NewValue(PAnsiChar(UTF8String(val.AsString)));
-      tkLString: Result := Eng.NewValue(PAnsiChar(UTF8String(val.AsString)));
-      tkWString: Result := Eng.NewValue(PAnsiChar(UTF8String(val.AsString)));
+      tkWChar: Result := UnicodeToJSValue(val.AsString, Eng);
+      tkLString: Result := UnicodeToJSValue(val.AsString, Eng);
+      tkWString: Result := UnicodeToJSValue(val.AsString, Eng);
       tkVariant: Result := MakeVariant;
       tkArray: Result := TValueToArray(val, Eng, IntfList);
       tkRecord: Result := TValueToJSRecord(val, Eng, IntfList);
       tkInterface: Result := MakeInterface;
       tkInt64: Result := Eng.NewValue(val.AsInteger);
       tkDynArray: Result := TValueToArray(val, Eng, IntfList);
-      tkUString: Result := Eng.NewValue(PAnsiChar(Utf8String(val.AsString)));
+      tkUString: Result := UnicodeToJSValue(val.AsString, Eng);
       tkClassRef: ;
       tkPointer: ;
       tkProcedure: ;
@@ -625,6 +656,25 @@ end;
 //    end;
   end;
 
+  function TValueToTypedArray(val: TValue; Eng: IEngine): IValue;
+  var
+    DoubleArr: TArray<Double>;
+    IntArr: TArray<Integer>;
+  begin
+    Result := nil;
+    //delphi array can be freed after return, so contents are copied
+    if val.TypeInfo = TypeInfo(TArray<Double>) then
+    begin
+      DoubleArr := val.AsType<TArray<Double>>;
+      Result := Eng.NewFloat64Array(Pointer(DoubleArr), Length(DoubleArr), True);
+    end
+    else if val.TypeInfo = TypeInfo(TArray<Integer>) then
+    begin
+      IntArr := val.AsType<TArray<Integer>>;
+      Result := Eng.NewInt32Array(Pointer(IntArr), Length(IntArr), True);
+    end;
+  end;
+
   function TryAsJSCallback(val: TValue; RecDescr: TRttiType;
     out jsVal: IBaseValue): Boolean;
   var
@@ -663,29 +713,59 @@ end;
     Prop: TRttiProperty;
     ValueType: TRttiType;
     Rec: IRecord;
+    Shape: IRecordShape;
+    NewShape: boolean;
+    Index: integer;
   begin
     if not Assigned(RecDescr) then
       RecDescr := TRttiContext.Create.GetType(recVal.TypeInfo);
     if not TryAsJSCallback(recVal, RecDescr, Result) then
     begin
-      Rec := Eng.NewRecord;
+      //field names are declared once per record type, then fields are set by index
+      Shape := Eng.RecordShape(RecDescr.Handle);
+      NewShape := Shape.FieldCount = 0;
       FieldArr := RecDescr.GetFields;
+      PropArr := RecDescr.GetProperties;
+      if NewShape then
+      begin
+        for Field in FieldArr do
+        begin
+          ValueType := Field.FieldType;
+          if (Field.Visibility = mvPublic) and (Assigned(ValueType)) and
+            (ValueType.TypeKind in tkProperties) then
+            Shape.AddField(PAnsiChar(UTF8String(Field.Name)));
+        end;
+        for Prop in PropArr do
+        begin
+          ValueType := Prop.PropertyType;
+          if (Prop.Visibility = mvPublic) and (Assigned(ValueType)) and (ValueType.TypeKind in tkProperties) then
+            Shape.AddField(PAnsiChar(UTF8String(Prop.Name)));
+        end;
+      end;
+
+      Rec := Eng.NewShapedRecord(Shape);
+      Index := 0;
       for Field in FieldArr do
       begin
         ValueType := Field.FieldType;
         if (Field.Visibility = mvPublic) and (Assigned(ValueType)) and
           (ValueType.TypeKind in tkProperties) then
-          Rec.SetField(PAnsiChar(UTF8String(Field.Name)),
+        begin
+          Rec.SetFieldAt(Index,
             TValueToJSValue(Field.GetValue(recVal.GetReferenceToRawData), Eng, IntfList));
+          Inc(Index);
+        end;
       end;
 
-      PropArr := RecDescr.GetProperties;
       for Prop in PropArr do
       begin
         ValueType := Prop.PropertyType;
         if (Prop.Visibility = mvPublic) and (Assigned(ValueType)) and (ValueType.TypeKind in tkProperties) then
-          Rec.SetField(PAnsiChar(UTF8String(Prop.Name)),
+        begin
+          Rec.SetFieldAt(Index,
             TValueToJSValue(Prop.GetValue(recVal.GetReferenceToRawData), Eng, IntfList));
+          Inc(Index);
+        end;
       end;
       Result := Rec;
     end;
@@ -696,6 +776,30 @@ end;
     Result := UTF8ToUnicodeString(RawByteString(s));
   end;
 
+  function JSValToUnicode(val: jsval): UnicodeString;
+  const
+    BufLen = 256;
+  var
+    Len: integer;
+    Buf: array[0..BufLen - 1] of WideChar;
+  begin
+    //short strings are taken by one call; longer ones by second call, which
+    //gets string converted by the first one
+    Len := val.AsUnicodeString(@Buf[0], BufLen);
+    if Len <= BufLen then
+      SetString(Result, PWideChar(@Buf[0]), Len)
+    else
+    begin
+      SetLength(Result, Len);
+      val.AsUnicodeString(PWideChar(Result), Len);
+    end;
+  end;
+
+  function UnicodeToJSValue(const s: UnicodeString; Eng: IEngine): IValue;
+  begin
+    Result := Eng.NewUnicodeString(PWideChar(s), Length(s));
+  end;
+
   function TypeHasAttribute(typ: TRttiType; attrClass: TAttrClass): boolean;
   var
     Attributes: TArray<TCustomAttribute>;
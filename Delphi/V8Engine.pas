@@ -107,8 +107,23 @@ type
     FDebugPort: string;
     FNodeEngineCreated, FInactive: boolean;
     FAdParams: string;
+    FWarmRun: boolean;
+    FSnapshot: TBytes;
+    FMaxOldSpace: integer;
+    FMaxSemiSpace: integer;
+    FCodeCacheDir: string;
+    FTranspileCacheDir: string;
+    FTranspileThreads: integer;
+    FStepMode: boolean;
+    FRunTimeLimit: integer;
+    FRunCpuLimit: integer;
+    FProfiling: boolean;
     FVars: TDictionary<string, TValue>;
     FInitError: string;
+    //props and fields are registered with their index in these lists,
+    //so callbacks find them by id instead of name
+    FPropSlots: TList<TPropInfo>;
+    FFieldSlots: TList<TRttiField>;
 
     const NODE_AVAILABLE_VER = 1;
 
@@ -123,6 +138,10 @@ type
     //get object by index (e.g. 'Objects[i]' in 'Model.Objects[i]')
     class procedure callIndexedPropNumberGetter(args: IGetterArgs); static; stdcall;
     class procedure callIndexedPropNumberSetter(args: ISetterArgs); static; stdcall;
+    //range of elements of list (e.g. 'Objects[i]'..'Objects[i + n - 1]' or 'List[i]'..'List[i + n - 1]'
+    //for default indexed prop); length of list is its Count property, so ranges of lists without
+    //Count are declined
+    class procedure callIndexedPropRange(args: IGetterArgs); static; stdcall;
     //get object by index name(e.g. 'Objects[ObjectName]' in 'Model.Objects[ObjectName]')
     class procedure callNamedPropNumberGetter(args: IGetterArgs); static; stdcall;
     class procedure callNamedPropNumberSetter(args: ISetterArgs); static; stdcall;
@@ -142,11 +161,28 @@ type
     procedure SetDebug(const Value: boolean);
     procedure SetDebugPort(const Value: string);
     procedure SetAdParams(const Value: string);
+    procedure SetWarmRun(const Value: boolean);
+    procedure SetCodeCacheDir(const Value: string);
+    procedure SetTranspileCacheDir(const Value: string);
+    procedure SetTranspileThreads(const Value: integer);
+    procedure SetStepMode(const Value: boolean);
+    procedure SetRunTimeLimit(const Value: integer);
+    procedure SetRunCpuLimit(const Value: integer);
+    procedure SetProfiling(const Value: boolean);
 
     function NodeLibAvailable: Boolean;
   public
     constructor Create;
+    //engine starts from startup snapshot, made by MakeSnapshot
+    constructor CreateWithSnapshot(const Snapshot: TBytes);
+    //heap limits in MB (0 - V8's default); near the limit script is interrupted
+    //and error message goes to ScriptLog
+    constructor CreateWithHeapLimits(MaxOldSpaceMb: integer; MaxSemiSpaceMb: integer = 0);
     destructor Destroy; override;
+    //snapshot of context after running Source (plain js without require and node's
+    //modules); code of WarmUpSource is compiled into snapshot too
+    class function MakeSnapshot(const Source: string;
+      const WarmUpSource: string = ''): TBytes;
     procedure IgnoreException(E: TClass);
     function AddClass(cType: TClass): TJSClass;
     function AddGlobal(global: TObject): TJSClass;
@@ -156,6 +192,11 @@ type
     function CallFunction(const Name: string; Args: array of TValue): TValue; overload;
     function CallFunction(const Name: string; Args: array of Variant): Variant; overload;
     function CallFunction(const Name: string): Variant; overload;
+    //resolves global function once for repeated and batch calls (nil if there is no such function)
+    function PrepareCall(const Name: string): IPreparedCall;
+    //calls function for every row of args (argsPerCall numbers per row)
+    function CallFunctionBatch(const Name: string; const Args: TArray<Double>;
+      argsPerCall: integer): TArray<Double>;
 
     property ScriptLog: TStrings read FLog;
     property Inactive: boolean read FInactive;
@@ -164,6 +205,40 @@ type
     property Debug: boolean read FDebug write SetDebug;
     property DebugPort: string read FDebugPort write SetDebugPort;
     property AdParams: string read FAdParams write SetAdParams;
+    //next scripts run in environment of the first one, without node's bootstrap;
+    //global state of previous scripts is kept
+    property WarmRun: boolean read FWarmRun write SetWarmRun;
+    //compiled code of include code, include files and modules is kept in this dir
+    //and reused by next engines (while source and node.dll are the same)
+    property CodeCacheDir: string read FCodeCacheDir write SetCodeCacheDir;
+    procedure GetCodeCacheStats(out Hits, Misses, Rejects: Int64);
+    //transpiled .ts modules are kept in this dir, so unchanged sources aren't transpiled again
+    property TranspileCacheDir: string read FTranspileCacheDir write SetTranspileCacheDir;
+    //if it isn't 0, .ts modules, imported by main module (directly or not), are transpiled
+    //by this count of threads before main module is run (-1 - count of processors)
+    property TranspileThreads: integer read FTranspileThreads write SetTranspileThreads;
+    //RunScript/RunFile return after script's first tick; its timers and i/o
+    //are run by RunFor/PumpOnce from host's own loop (e.g. Application.OnIdle)
+    property StepMode: boolean read FStepMode write SetStepMode;
+    //runs started script for ms at most; false if script is finished
+    function RunFor(ms: integer): boolean;
+    //runs ready callbacks of started script without waiting; false if script is finished
+    function PumpOnce: boolean;
+    //limits (ms, 0 - no limit) of wall time and of cpu time of engine's thread for every
+    //RunScript/RunFile/RunFor/PumpOnce; longer script is interrupted
+    property RunTimeLimit: integer read FRunTimeLimit write SetRunTimeLimit;
+    property RunCpuLimit: integer read FRunCpuLimit write SetRunCpuLimit;
+    //stops running script; unlike other methods, it can be called from any thread
+    procedure Interrupt;
+    procedure GetHeapStatistics(out Stats: THeapStatistics);
+    //full gc, e.g. when host is short of memory
+    procedure LowMemoryNotification;
+    //count and time of calls of every registered method/property by scripts;
+    //ProfileJSON is array of {class, member, kind, calls, totalNs, hostNs,
+    //bridgeNs, maxNs, p50Ns, p90Ns, p99Ns}
+    property Profiling: boolean read FProfiling write SetProfiling;
+    function ProfileJSON: string;
+    procedure ResetProfile;
     property InitError: string read FInitError;
     function RunScript(code, scriptName: string): TValue;
     function RunIncludeCode(code: string): string;
@@ -175,6 +250,35 @@ type
     class function GetFullVersion: string;
   end;
 
+  //creates engine for pool and registers its globals
+  TJSEngineFactory = reference to function: TJSEngine;
+
+  //pool of ready engines for scripts, which are run by several threads.
+  //every engine has its own isolate and event loop, but isolate is locked by
+  //the thread, which created engine, so engine is given only to that thread
+  TJSEnginePool = class
+  private
+    FFactory: TJSEngineFactory;
+    FIdle: TObjectDictionary<TThreadID, TObjectStack<TJSEngine>>;
+    FBusy: TDictionary<TJSEngine, TThreadID>;
+    FMaxIdlePerThread: integer;
+    function ThreadIdle(ThreadId: TThreadID): TObjectStack<TJSEngine>;
+  public
+    constructor Create(Factory: TJSEngineFactory; MaxIdlePerThread: integer = 4);
+    //every thread, which used pool, has to call ClearThread and release its engines
+    //before pool is destroyed: engines can't be freed by other thread
+    destructor Destroy; override;
+    //creates Count engines for current thread in advance. Engines aren't moved between
+    //threads, so every worker thread prewarms its own ones (e.g. at its start). Engines
+    //are switched to warm run and run BootstrapCode, so node's bootstrap is done here
+    //and scripts of acquired engine run in that environment
+    procedure Prewarm(Count: integer; const BootstrapCode: string = '');
+    function Acquire: TJSEngine;
+    procedure Release(Engine: TJSEngine);
+    //frees idle engines of current thread (should be called before thread ends)
+    procedure ClearThread;
+  end;
+
 
 implementation
 
@@ -341,8 +445,9 @@ begin
       ReturnClass := prop.PropertyType.Handle.TypeData.ClassType;
       AddClass(ReturnClass);
     end;
-    FGlobalTemplate.SetProp(PAnsiChar(UTF8String(prop.Name)),
-      propPair.Value.propObj, prop.IsReadable, prop.IsWritable);
+    FGlobalTemplate.SetPropWithId(PAnsiChar(UTF8String(prop.Name)),
+      propPair.Value.propObj, prop.IsReadable, prop.IsWritable,
+      FPropSlots.Add(propPair.Value));
   end;
   //here setting enumerators to global object;
 
@@ -377,6 +482,7 @@ var
   Eng: TJSEngine;
   ClassDescr: TJSClass;
   Field: TRttiField;
+  FieldId: integer;
   Result: TValue;
   cl: TClass;
   obj: TObject;
@@ -388,8 +494,14 @@ begin
   Eng := TJSEngine(args.GetEngine);
   if Assigned(Eng) then
     try
-      ClassDescr := Eng.FClasses.Items[cl];
-      Field := ClassDescr.FFields.Items[PUtf8CharToString(args.GetPropName)];
+      FieldId := args.GetPropId;
+      if FieldId >= 0 then
+        Field := Eng.FFieldSlots[FieldId]
+      else
+      begin
+        ClassDescr := Eng.FClasses.Items[cl];
+        Field := ClassDescr.FFields.Items[PUtf8CharToString(args.GetPropName)];
+      end;
       if cl = Eng.FGlobal.ClassType then
         obj := Eng.FGlobal
       else
@@ -424,6 +536,7 @@ class procedure TJSEngine.callFieldSetter(args: ISetterArgs);
 var
   ClassDescr: TJSClass;
   Field: TRttiField;
+  FieldId: integer;
   ResultValue: TValue;
   cl: TClass;
   obj: TObject;
@@ -435,8 +548,14 @@ begin
   Eng := TJSEngine(args.GetEngine);
   if Assigned(Eng) then
     try
-      ClassDescr := Eng.FClasses.Items[cl];
-      Field := ClassDescr.FFields.Items[PUtf8CharToString(args.GetPropName)];
+      FieldId := args.GetPropId;
+      if FieldId >= 0 then
+        Field := Eng.FFieldSlots[FieldId]
+      else
+      begin
+        ClassDescr := Eng.FClasses.Items[cl];
+        Field := ClassDescr.FFields.Items[PUtf8CharToString(args.GetPropName)];
+      end;
       if cl = Eng.FGlobal.ClassType then
         obj := Eng.FGlobal
       else
@@ -476,15 +595,21 @@ begin
   if not FInactive then
   begin
     count := Length(Args);
-    JsArgs := FEngine.NewArray(count);
-    if not Assigned(JsArgs) then
-      raise EScriptEngineException.Create('Can not create an array to call a function');
-    for i := 0 to count - 1 do
-    begin
-      JsArgs.SetValue(
-        TValueToJSValue(Tvalue.FromVariant(Args[i]), FEngine, FDispatchList), i);
+    //args and result are converted here, so engine's values are released after call
+    FEngine.BeginValueScope;
+    try
+      JsArgs := FEngine.NewArray(count);
+      if not Assigned(JsArgs) then
+        raise EScriptEngineException.Create('Can not create an array to call a function');
+      for i := 0 to count - 1 do
+      begin
+        JsArgs.SetValue(
+          TValueToJSValue(Tvalue.FromVariant(Args[i]), FEngine, FDispatchList), i);
+      end;
+      Result := JsValToTValue(CallFunction(name, JsArgs)).AsVariant;
+    finally
+      FEngine.EndValueScope;
     end;
-    Result := JsValToTValue(CallFunction(name, JsArgs)).AsVariant;
   end;
 end;
 
@@ -500,18 +625,49 @@ begin
   if not FInactive then
   begin
     count := Length(Args);
-    JsArgs := FEngine.NewArray(count);
-    if not Assigned(JsArgs) then
-      raise EScriptEngineException.Create('Can not create an array to call a function');
-    for i := 0 to count - 1 do
-    begin
-      JsArgs.SetValue(TValueToJSValue(Args[i], FEngine, FDispatchList), i);
+    FEngine.BeginValueScope;
+    try
+      JsArgs := FEngine.NewArray(count);
+      if not Assigned(JsArgs) then
+        raise EScriptEngineException.Create('Can not create an array to call a function');
+      for i := 0 to count - 1 do
+      begin
+        JsArgs.SetValue(TValueToJSValue(Args[i], FEngine, FDispatchList), i);
+      end;
+      resValue := CallFunction(name, JsArgs);
+      Result := JsValToTValue(resValue);
+    finally
+      FEngine.EndValueScope;
     end;
-    resValue := CallFunction(name, JsArgs);
-    Result := JsValToTValue(resValue);
   end;
 end;
 
+function TJSEngine.PrepareCall(const Name: string): IPreparedCall;
+begin
+  Result := nil;
+  if not FInactive then
+    Result := FEngine.PrepareCall(PAnsiChar(UTF8String(Name)));
+end;
+
+function TJSEngine.CallFunctionBatch(const Name: string;
+  const Args: TArray<Double>; argsPerCall: integer): TArray<Double>;
+var
+  Call: IPreparedCall;
+  callsCount: integer;
+begin
+  Result := nil;
+  Call := PrepareCall(Name);
+  if not Assigned(Call) then
+    raise EScriptEngineException.Create('There is no function "' + Name + '"');
+  if argsPerCall > 0 then
+    callsCount := Length(Args) div argsPerCall
+  else
+    callsCount := 0;
+  SetLength(Result, callsCount);
+  if callsCount > 0 then
+    Call.CallBatchNumbers(@Args[0], argsPerCall, callsCount, @Result[0]);
+end;
+
 function TJSEngine.CallFunction(name: string; Args: IValuesArray): IValue;
 var
   Utf8Name: UTF8String;
@@ -689,6 +845,82 @@ begin
     end;
 end;
 
+class procedure TJSEngine.callIndexedPropRange(args: IGetterArgs);
+var
+  Eng: TJSEngine;
+  ClassTypeSlotItem: TObject;
+  Prop: TRttiIndexedProperty;
+  Params: TArray<TRttiParameter>;
+  CountProp: TRttiProperty;
+  cl: TClass;
+  obj: TObject;
+  Values: IValuesArray;
+  Count, First, Last, i: integer;
+begin
+  Eng := TJSEngine(args.GetEngine);
+  obj := nil;
+  Prop := nil;
+  cl := nil;
+  if Assigned(Eng) then
+    try
+      ClassTypeSlotItem := TObject(args.GetDelphiClasstype);
+      if not Assigned(ClassTypeSlotItem) then
+        Exit;
+      if ClassTypeSlotItem is TClass then
+        cl := TClass(ClassTypeSlotItem);
+      if ClassTypeSlotItem.ClassType = TRttiIndexedProperty then
+      begin
+        //prop pointer was writed in classtype slot;
+        Prop := TRttiIndexedProperty(ClassTypeSlotItem);
+        obj := args.GetDelphiObject;
+      end
+      else if Assigned(cl) then
+      begin
+        Prop := Eng.FClasses.Items[cl].FDefaultIndexedProp;
+        obj := args.GetDelphiObject;
+      end;
+      if not Assigned(Prop) or not Assigned(obj) or not Prop.IsReadable then
+        Exit;
+      Params := Prop.ReadMethod.GetParameters;
+      if (Length(Params) <> 1) or (Params[0].ParamType.TypeKind <> tkInteger) then
+        Exit;
+      CountProp := RttiContext.GetType(obj.ClassType).GetProperty('Count');
+      if not Assigned(CountProp) or not CountProp.IsReadable or
+        (CountProp.PropertyType.TypeKind <> tkInteger) then
+        Exit;
+      Count := CountProp.GetValue(obj).AsInteger;
+      First := args.GetPropIndex;
+      Last := Min(First + args.GetRangeCount, Count) - 1;
+      //elements are converted here, so engine's values are released after call
+      Eng.FEngine.BeginValueScope;
+      try
+        Values := Eng.FEngine.NewArray(Max(Last - First + 1, 0));
+        for i := First to Last do
+          Values.SetValue(TValueToJSValue(Prop.GetValue(obj, [i]), Eng.FEngine,
+            Eng.FDispatchList), i - First);
+        args.SetRangeResult(Values, Count);
+      finally
+        Eng.FEngine.EndValueScope;
+      end;
+    except
+      on E:Exception do
+      begin
+        if Assigned(eng.FLog) then
+        begin
+          if Eng.FIgnoredExceptions.IndexOf(e.ClassType) < 0 then
+          begin
+            eng.FLog.Add('Uncaught exception: ' + E.Message);
+            args.SetError(PAnsiChar(UTF8String('Uncaught exception: ' + E.Message)));
+          end
+          {$ifdef DEBUG}
+          else
+            eng.FLog.Add('--' + E.Message);
+          {$endif}
+        end;
+      end;
+    end;
+end;
+
 class procedure TJSEngine.callIntfGetter(args: IGetterArgs);
 var
   Eng: TJSEngine;
@@ -829,6 +1061,7 @@ var
   obj: TObject;
   Helper: TJSClassExtender;
   PropInfo: TPropInfo;
+  PropId: integer;
   FoundVar: boolean;
 begin
   //invoke right method of right object;
@@ -838,11 +1071,12 @@ begin
   Eng := TJSEngine(args.GetEngine);
   if Assigned(Eng) then
     try
-      ClassDescr := Eng.FClasses.Items[cl];
       FoundVar := False;
+      PropId := args.GetPropId;
       if cl = Eng.FGlobal.ClassType then
       begin
-        if Eng.FVars.TryGetValue(PUtf8CharToString(args.GetPropName), Result) then
+        //declared vars are registered without id
+        if (PropId < 0) and Eng.FVars.TryGetValue(PUtf8CharToString(args.GetPropName), Result) then
           FoundVar := True;
         obj := Eng.FGlobal
       end
@@ -852,7 +1086,13 @@ begin
       end;
       if not FoundVar then
       begin
-        PropInfo := ClassDescr.FProps.Items[PUtf8CharToString(args.GetPropName)];
+        if PropId >= 0 then
+          PropInfo := Eng.FPropSlots[PropId]
+        else
+        begin
+          ClassDescr := Eng.FClasses.Items[cl];
+          PropInfo := ClassDescr.FProps.Items[PUtf8CharToString(args.GetPropName)];
+        end;
         helper := PropInfo.propObj;
         if Assigned(Helper) then
         begin
@@ -919,6 +1159,7 @@ var
   cl: TClass;
   obj: TObject;
   Helper: TJSClassExtender;
+  TypedResult: IValue;
 begin
   //invoke right method of right object;
   cl := TClass(args.GetDelphiClasstype);
@@ -964,7 +1205,13 @@ begin
             Eng.FGarbageCollector.AddObject(Result.AsObject);
       if Assigned(Method.ReturnType) then
       begin
-        args.SetReturnValue(TValueToJSValue(Result, Eng.FEngine, Eng.FDispatchList));
+        TypedResult := nil;
+        if (Method.ReturnType.TypeKind = tkDynArray) and HasAttribute(Method, TTypedArrayAttr) then
+          TypedResult := TValueToTypedArray(Result, Eng.FEngine);
+        if Assigned(TypedResult) then
+          args.SetReturnValue(TypedResult)
+        else
+          args.SetReturnValue(TValueToJSValue(Result, Eng.FEngine, Eng.FDispatchList));
       end;
     except
       on E:Exception do
@@ -1120,6 +1367,8 @@ class procedure TJSEngine.callPropSetter(args: ISetterArgs);
 var
   ClassDescr: TJSClass;
   Prop: TRttiProperty;
+  PropInfo: TPropInfo;
+  PropId: integer;
   cl: TClass;
   obj: TObject;
   helper: TJSClassExtender;
@@ -1132,13 +1381,20 @@ begin
   Eng := TJSEngine(args.GetEngine);
   if Assigned(Eng) then
     try
-      ClassDescr := Eng.FClasses.Items[cl];
-      Prop := ClassDescr.FProps.Items[PUtf8CharToString(args.GetPropName)].prop;
+      PropId := args.GetPropId;
+      if PropId >= 0 then
+        PropInfo := Eng.FPropSlots[PropId]
+      else
+      begin
+        ClassDescr := Eng.FClasses.Items[cl];
+        PropInfo := ClassDescr.FProps.Items[PUtf8CharToString(args.GetPropName)];
+      end;
+      Prop := PropInfo.prop;
       if cl = Eng.FGlobal.ClassType then
         obj := Eng.FGlobal
       else
         obj := args.GetDelphiObject;
-      helper := ClassDescr.FProps.Items[PUtf8CharToString(args.GetPropName)].propObj;
+      helper := PropInfo.propObj;
       if Assigned(Helper) then
       begin
         helper.Source := obj;
@@ -1176,6 +1432,44 @@ begin
   Result := FClasses.ContainsKey(cType);
 end;
 
+constructor TJSEngine.CreateWithSnapshot(const Snapshot: TBytes);
+begin
+  FSnapshot := Snapshot;
+  Create;
+end;
+
+constructor TJSEngine.CreateWithHeapLimits(MaxOldSpaceMb, MaxSemiSpaceMb: integer);
+begin
+  FMaxOldSpace := MaxOldSpaceMb;
+  FMaxSemiSpace := MaxSemiSpaceMb;
+  Create;
+end;
+
+class function TJSEngine.MakeSnapshot(const Source, WarmUpSource: string): TBytes;
+var
+  Data: PByte;
+  Size: integer;
+  WarmUp: UTF8String;
+  WarmUpPtr: PAnsiChar;
+begin
+  Result := nil;
+  WarmUpPtr := nil;
+  if WarmUpSource <> '' then
+  begin
+    WarmUp := UTF8String(WarmUpSource);
+    WarmUpPtr := PAnsiChar(WarmUp);
+  end;
+  Data := CreateStartupSnapshot(PAnsiChar(UTF8String(Source)), WarmUpPtr, Size);
+  if not Assigned(Data) then
+    Exit;
+  try
+    SetLength(Result, Size);
+    Move(Data^, Result[0], Size);
+  finally
+    FreeStartupSnapshot(Data);
+  end;
+end;
+
 constructor TJSEngine.Create;
 begin
   FNodeEngineCreated := False;
@@ -1192,9 +1486,24 @@ begin
   FDispatchList := TInterfaceList.Create;
   FEnumList := TList<PTypeInfo>.Create;
   FVars := TDictionary<string, TValue>.Create();
+  FPropSlots := TList<TPropInfo>.Create;
+  FFieldSlots := TList<TRttiField>.Create;
   try
     if NodeLibAvailable then
-      FEngine := InitEngine(Self)
+    begin
+      if (FMaxOldSpace > 0) or (FMaxSemiSpace > 0) then
+      begin
+        if Length(FSnapshot) > 0 then
+          FEngine := InitEngineWithHeapLimits(Self, @FSnapshot[0], Length(FSnapshot),
+            FMaxOldSpace, FMaxSemiSpace)
+        else
+          FEngine := InitEngineWithHeapLimits(Self, nil, 0, FMaxOldSpace, FMaxSemiSpace);
+      end
+      else if Length(FSnapshot) > 0 then
+        FEngine := InitEngineWithSnapshot(Self, @FSnapshot[0], Length(FSnapshot))
+      else
+        FEngine := InitEngine(Self);
+    end
     else
       FInitError := Format('Failed to intialize node.dll. ' +
         'Incorrect version. Required %d version', [NODE_AVAILABLE_VER]);
@@ -1222,6 +1531,7 @@ begin
     FEngine.SetInterfaceSetterCallBack(callIntfSetter);
     FEngine.SetInterfaceMethodCallBack(callIntfMethod);
     FEngine.SetIndexedPropGetterObjCallBack(callIndexedObjGetter);
+    FEngine.SetIndexedPropRangeCallBack(callIndexedPropRange);
 
     FEngine.SetErrorMessageCallBack(SendErrToLog);
     FEngine.SetClassTypeChecker(GetRegisteredParentClasstype);
@@ -1256,6 +1566,8 @@ begin
   FClassList.Free;
   FIgnoredExceptions.Free;
   FVars.Free;
+  FPropSlots.Free;
+  FFieldSlots.Free;
 end;
 
 class function TJSEngine.GetFullVersion: string;
@@ -1519,8 +1831,34 @@ procedure TJSEngine.SetClassIntoContext(cl: TJSClass);
     end;
   end;
 
+  function SameMethods(m1, m2: TMethodOverloadMap): boolean;
+  var
+    i: integer;
+  begin
+    Result := (m1.MethodInfo.Method = m2.MethodInfo.Method) and
+      (m1.MethodInfo.Helper = m2.MethodInfo.Helper) and
+      (Assigned(m1.OverloadsInfo) = Assigned(m2.OverloadsInfo));
+    if Result and Assigned(m1.OverloadsInfo) then
+    begin
+      Result := m1.OverloadsInfo.Count = m2.OverloadsInfo.Count;
+      i := 0;
+      while Result and (i < m1.OverloadsInfo.Count) do
+      begin
+        Result := (m1.OverloadsInfo[i].Method = m2.OverloadsInfo[i].Method) and
+          (m1.OverloadsInfo[i].Helper = m2.OverloadsInfo[i].Helper);
+        Inc(i);
+      end;
+    end;
+  end;
+
 var
   objTempl: IObjectTemplate;
+  ParentTempl: IObjectTemplate;
+  ParentDescr: TJSClass;
+  ParentMethods: TMethodOverloadMap;
+  ParentProp: TPropInfo;
+  ParentField: TRttiField;
+  ParentIndProp: TRttiIndexedProperty;
   Methods: TMethodOverloadMap;
   method: TRttiMethod;
   ReturnClass: TClass;
@@ -1547,10 +1885,22 @@ begin
       clParent := clParent.ClassParent;
     end;
     objTempl := FEngine.AddObject(PAnsiChar(UTF8String(cl.Ftype.ToString)), cl.FClasstype);
-    objTempl.SetParent(GetParent(cl.cType.ClassParent));
+    ParentTempl := GetParent(cl.cType.ClassParent);
+    objTempl.SetParent(ParentTempl);
+    //js object inherits members of parent's template, so members, which are
+    //the same as parent's ones, are not registered again
+    ParentDescr := nil;
+    if Assigned(ParentTempl) and
+      FClasses.TryGetValue(cl.cType.ClassParent, ParentDescr) and
+      not ParentDescr.Initialized then
+      ParentDescr := nil;
     for Overloads in cl.FMethods do
     begin
       Methods := Overloads.Value;
+      if Assigned(ParentDescr) and
+        ParentDescr.FMethods.TryGetValue(Overloads.Key, ParentMethods) and
+        SameMethods(Methods, ParentMethods) then
+        continue;
       if Assigned(Methods.MethodInfo.Method) then
       begin
         method := Methods.MethodInfo.Method;
@@ -1585,7 +1935,12 @@ begin
     for PropPair in cl.FProps do
     begin
       Prop := PropPair.Value.prop;
-      objTempl.SetProp(PAnsiChar(UTF8String(Prop.Name)), PropPair.Value.propObj, Prop.IsReadable, Prop.IsWritable);
+      if Assigned(ParentDescr) and
+        ParentDescr.FProps.TryGetValue(PropPair.Key, ParentProp) and
+        (ParentProp.prop = Prop) and (ParentProp.propObj = PropPair.Value.propObj) then
+        continue;
+      objTempl.SetPropWithId(PAnsiChar(UTF8String(Prop.Name)), PropPair.Value.propObj,
+        Prop.IsReadable, Prop.IsWritable, FPropSlots.Add(PropPair.Value));
       if Assigned(Prop.PropertyType) then
       begin
         if (Prop.PropertyType.TypeKind = tkClass) then
@@ -1600,7 +1955,11 @@ begin
     for FieldPair in cl.FFields do
     begin
       field := FieldPair.Value;
-      objTempl.SetField(PAnsiChar(UTF8String(field.Name)));
+      if Assigned(ParentDescr) and
+        ParentDescr.FFields.TryGetValue(FieldPair.Key, ParentField) and
+        (ParentField = field) then
+        continue;
+      objTempl.SetFieldWithId(PAnsiChar(UTF8String(field.Name)), FFieldSlots.Add(field));
       if Assigned(field.FieldType) then
       begin
         if (field.FieldType.TypeKind = tkClass) then
@@ -1615,6 +1974,10 @@ begin
     for IndPropPair in cl.IndexedProps do
     begin
       IndProp := IndPropPair.Value;
+      if Assigned(ParentDescr) and
+        ParentDescr.IndexedProps.TryGetValue(IndPropPair.Key, ParentIndProp) and
+        (ParentIndProp = IndProp) then
+        continue;
       objTempl.SetIndexedProp(PAnsiChar(UTF8String(IndProp.Name)), nil,
         IndProp.IsReadable, IndProp.IsWritable);
     end;
@@ -1628,6 +1991,120 @@ begin
   FDebug := Value;
 end;
 
+procedure TJSEngine.SetWarmRun(const Value: boolean);
+begin
+  FWarmRun := Value;
+  if not FInactive then
+    FEngine.SetWarmRun(Value);
+end;
+
+procedure TJSEngine.SetCodeCacheDir(const Value: string);
+begin
+  FCodeCacheDir := Value;
+  if not FInactive then
+    FEngine.SetCodeCacheDir(PAnsiChar(UTF8String(Value)));
+end;
+
+procedure TJSEngine.SetTranspileCacheDir(const Value: string);
+begin
+  FTranspileCacheDir := Value;
+  if not FInactive then
+    FEngine.SetTranspileCacheDir(PAnsiChar(UTF8String(Value)));
+end;
+
+procedure TJSEngine.SetTranspileThreads(const Value: integer);
+begin
+  FTranspileThreads := Value;
+  if not FInactive then
+    FEngine.SetTranspileThreads(Value);
+end;
+
+procedure TJSEngine.SetStepMode(const Value: boolean);
+begin
+  FStepMode := Value;
+  if not FInactive then
+    FEngine.SetStepMode(Value);
+end;
+
+function TJSEngine.RunFor(ms: integer): boolean;
+begin
+  Result := False;
+  if not FInactive then
+    Result := FEngine.RunFor(ms) > 0;
+end;
+
+function TJSEngine.PumpOnce: boolean;
+begin
+  Result := False;
+  if not FInactive then
+    Result := FEngine.PumpOnce > 0;
+end;
+
+procedure TJSEngine.SetRunTimeLimit(const Value: integer);
+begin
+  FRunTimeLimit := Value;
+  if not FInactive then
+    FEngine.SetRunLimits(FRunTimeLimit, FRunCpuLimit);
+end;
+
+procedure TJSEngine.SetRunCpuLimit(const Value: integer);
+begin
+  FRunCpuLimit := Value;
+  if not FInactive then
+    FEngine.SetRunLimits(FRunTimeLimit, FRunCpuLimit);
+end;
+
+procedure TJSEngine.Interrupt;
+begin
+  if not FInactive then
+    FEngine.Interrupt;
+end;
+
+procedure TJSEngine.GetHeapStatistics(out Stats: THeapStatistics);
+begin
+  FillChar(Stats, SizeOf(Stats), 0);
+  if not FInactive then
+    FEngine.GetHeapStatistics(Stats);
+end;
+
+procedure TJSEngine.LowMemoryNotification;
+begin
+  if not FInactive then
+    FEngine.LowMemoryNotification;
+end;
+
+procedure TJSEngine.SetProfiling(const Value: boolean);
+begin
+  FProfiling := Value;
+  if not FInactive then
+    FEngine.SetProfiling(Value);
+end;
+
+function TJSEngine.ProfileJSON: string;
+begin
+  Result := '[]';
+  if not FInactive then
+    Result := PUtf8CharToString(FEngine.ProfileJSON);
+end;
+
+procedure TJSEngine.ResetProfile;
+begin
+  if not FInactive then
+    FEngine.ResetProfile;
+end;
+
+procedure TJSEngine.GetCodeCacheStats(out Hits, Misses, Rejects: Int64);
+begin
+  Hits := 0;
+  Misses := 0;
+  Rejects := 0;
+  if FInactive then
+    Exit;
+  Hits := FEngine.CodeCacheHits;
+  Misses := FEngine.CodeCacheMisses;
+  Rejects := FEngine.CodeCacheRejects;
+end;
+
 procedure TJSEngine.SetDebugPort(const Value: string);
 begin
   FDebugPort := Value;
@@ -1662,6 +2139,121 @@ begin
   end;
 end;
 
+{ TJSEnginePool }
+
+constructor TJSEnginePool.Create(Factory: TJSEngineFactory; MaxIdlePerThread: integer);
+begin
+  FFactory := Factory;
+  FMaxIdlePerThread := MaxIdlePerThread;
+  FIdle := TObjectDictionary<TThreadID, TObjectStack<TJSEngine>>.Create([doOwnsValues]);
+  FBusy := TDictionary<TJSEngine, TThreadID>.Create;
+end;
+
+destructor TJSEnginePool.Destroy;
+var
+  Idle: TObjectStack<TJSEngine>;
+begin
+  Assert((FIdle.Count = 0) and (FBusy.Count = 0),
+    'engines of pool should be released and cleared by their threads (ClearThread)');
+  //engines, which weren't cleared, are left rather than freed by wrong thread
+  for Idle in FIdle.Values do
+    Idle.OwnsObjects := False;
+  FIdle.Free;
+  FBusy.Free;
+  inherited;
+end;
+
+function TJSEnginePool.ThreadIdle(ThreadId: TThreadID): TObjectStack<TJSEngine>;
+begin
+  if not FIdle.TryGetValue(ThreadId, Result) then
+  begin
+    Result := TObjectStack<TJSEngine>.Create(True);
+    FIdle.Add(ThreadId, Result);
+  end;
+end;
+
+procedure TJSEnginePool.Prewarm(Count: integer; const BootstrapCode: string);
+var
+  i: integer;
+  Engine: TJSEngine;
+begin
+  for i := 0 to Count - 1 do
+  begin
+    Engine := FFactory();
+    try
+      Engine.WarmRun := True;
+      Engine.RunScript(BootstrapCode, ParamStr(0));
+    except
+      Engine.Free;
+      raise;
+    end;
+    TMonitor.Enter(Self);
+    try
+      ThreadIdle(TThread.CurrentThread.ThreadID).Push(Engine);
+    finally
+      TMonitor.Exit(Self);
+    end;
+  end;
+end;
+
+function TJSEnginePool.Acquire: TJSEngine;
+var
+  Idle: TObjectStack<TJSEngine>;
+begin
+  Result := nil;
+  TMonitor.Enter(Self);
+  try
+    Idle := ThreadIdle(TThread.CurrentThread.ThreadID);
+    if Idle.Count > 0 then
+      Result := Idle.Extract;
+  finally
+    TMonitor.Exit(Self);
+  end;
+  //engine is created outside of lock, other threads don't wait for it
+  if not Assigned(Result) then
+    Result := FFactory();
+  TMonitor.Enter(Self);
+  try
+    FBusy.Add(Result, TThread.CurrentThread.ThreadID);
+  finally
+    TMonitor.Exit(Self);
+  end;
+end;
+
+procedure TJSEnginePool.Release(Engine: TJSEngine);
+var
+  ThreadId: TThreadID;
+  Idle: TObjectStack<TJSEngine>;
+begin
+  TMonitor.Enter(Self);
+  try
+    if not FBusy.TryGetValue(Engine, ThreadId) then
+      raise EScriptEngineException.Create('Engine is not acquired from this pool');
+    if ThreadId <> TThread.CurrentThread.ThreadID then
+      raise EScriptEngineException.Create('Engine should be released by thread, which acquired it');
+    FBusy.Remove(Engine);
+    Idle := ThreadIdle(ThreadId);
+    if Idle.Count < FMaxIdlePerThread then
+    begin
+      Idle.Push(Engine);
+      Engine := nil;
+    end;
+  finally
+    TMonitor.Exit(Self);
+  end;
+  Engine.Free;
+end;
+
+procedure TJSEnginePool.ClearThread;
+begin
+  TMonitor.Enter(Self);
+  try
+    FIdle.Remove(TThread.CurrentThread.ThreadID);
+  finally
+    TMonitor.Exit(Self);
+  end;
+end;
+
 { TJSClass }
 
 procedure TJSClass.AddHelper(helper: TJSClassExtender);
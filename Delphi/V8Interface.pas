@@ -2,11 +2,19 @@ unit V8Interface;
 
 interface
 
+const
+  //kinds of typed arrays, returned by IValue.AsTypedArray
+  TYPED_ARRAY_NONE = 0;
+  TYPED_ARRAY_FLOAT64 = 1;
+  TYPED_ARRAY_INT32 = 2;
+  TYPED_ARRAY_OTHER = 3;
+
 type
 
   IObject = class;
   IValuesArray = class;
   IRecord = class;
+  IRecordShape = class;
   IValue = class;
 
   IEngineIntf = class
@@ -44,6 +52,18 @@ type
     function CallFunction: IValue; virtual; stdcall; abstract;
   end;
 
+  //global js function, resolved once; lives until engine is destroyed
+  IPreparedCall = class (IEngineIntf)
+    //result is valid until next call
+    function Call(args: IValuesArray): IValue; virtual; stdcall; abstract;
+    //argsBatch contains arrays of args, one array per call; result of failed call is undefined
+    function CallBatch(argsBatch: IValuesArray): IValuesArray; virtual; stdcall; abstract;
+    //args has argsPerCall numbers for every call; NaN is written for failed calls;
+    //returns count of failed calls
+    function CallBatchNumbers(args: PDouble; argsPerCall, callsCount: integer;
+      results: PDouble): integer; virtual; stdcall; abstract;
+  end;
+
   IValuesArray = class (IBaseValue)
     function GetCount: integer; virtual; stdcall; abstract;
     function GetValue(index: integer): IValue; virtual; stdcall; abstract;
@@ -63,6 +83,28 @@ type
     function GetBoolField(NAme: PAnsiChar): boolean; virtual; stdcall; abstract;
     function GetStringField(NAme: PAnsiChar): PAnsiChar; virtual; stdcall; abstract;
     function GetObjectField(NAme: PAnsiChar): TObject; virtual; stdcall; abstract;
+
+    //fields by index in shape (record from NewShapedRecord has shape already)
+    procedure SetShape(shape: IRecordShape); virtual; stdcall; abstract;
+    procedure SetFieldAt(index: integer; val: integer); overload; virtual; stdcall; abstract;
+    procedure SetFieldAt(index: integer; val: double); overload; virtual; stdcall; abstract;
+    procedure SetFieldAt(index: integer; val: boolean); overload; virtual; stdcall; abstract;
+    procedure SetFieldAt(index: integer; val: PAnsiChar); overload; virtual; stdcall; abstract;
+    procedure SetFieldAt(index: integer; val: IBaseValue); overload; virtual; stdcall; abstract;
+    function GetIntFieldAt(index: integer): integer; virtual; stdcall; abstract;
+    function GetDoubleFieldAt(index: integer): double; virtual; stdcall; abstract;
+    function GetBoolFieldAt(index: integer): boolean; virtual; stdcall; abstract;
+    function GetStringFieldAt(index: integer): PAnsiChar; virtual; stdcall; abstract;
+    //see IValue.AsUnicodeString
+    function GetUnicodeStringField(Name: PAnsiChar; buf: PWideChar; len: integer): integer; virtual; stdcall; abstract;
+  end;
+
+  //field list, declared once for records of the same type; records of
+  //one shape share V8's hidden class. Shape is owned by engine
+  IRecordShape = class(IEngineIntf)
+    //returns index of field
+    function AddField(name: PAnsiChar): integer; virtual; stdcall; abstract;
+    function FieldCount: integer; virtual; stdcall; abstract;
   end;
 
   IValue = class (IBaseValue)
@@ -84,6 +126,15 @@ type
     function AsArray: IValuesArray; virtual; stdcall; abstract;
     function AsRecord: IRecord; virtual; stdcall; abstract;
     function AsFunction: IFunction; virtual; stdcall; abstract;
+    //args' values are valid only inside callback, detached value lives until engine is destroyed
+    function Detach: IValue; virtual; stdcall; abstract;
+    //data points to typed array's contents (no copy), len is count of elements
+    //(count of bytes for TYPED_ARRAY_OTHER); returns TYPED_ARRAY_* kind
+    function AsTypedArray(out data: Pointer; out len: NativeUInt): integer; virtual; stdcall; abstract;
+    //writes up to len chars to buf (without #0) and returns length of string;
+    //buf can be nil to get length only. If string doesn't fit, the next call
+    //with larger buffer takes string converted by this one
+    function AsUnicodeString(buf: PWideChar; len: integer): integer; virtual; stdcall; abstract;
   end;
 
   IMethodArgs = class (IEngineIntf)
@@ -107,6 +158,11 @@ type
     function GetDelphiMethod: TObject; virtual; stdcall; abstract;
 
     procedure SetError(errorType: PAnsiChar); virtual; stdcall; abstract;
+    //id from IObjectTemplate.SetMethodWithId (-1 if there is no id)
+    function GetMethodId: integer; virtual; stdcall; abstract;
+    procedure SetReturnValueUnicode(val: PWideChar; len: integer); virtual; stdcall; abstract;
+    //see IValue.AsUnicodeString
+    function GetMethodNameUnicode(buf: PWideChar; len: integer): integer; virtual; stdcall; abstract;
   end;
 
   IGetterArgs = class (IEngineIntf)
@@ -129,6 +185,14 @@ type
     procedure SetGetterResult(val: IBaseValue); overload; virtual; stdcall; abstract;
 
     procedure SetError(errorType: PAnsiChar); virtual; stdcall; abstract;
+    //id from IObjectTemplate.SetPropWithId/SetFieldWithId (-1 if there is no id)
+    function GetPropId: integer; virtual; stdcall; abstract;
+    procedure SetGetterResultUnicode(val: PWideChar; len: integer); virtual; stdcall; abstract;
+    //for range callback: count of elements from GetPropIndex, which are asked
+    function GetRangeCount: integer; virtual; stdcall; abstract;
+    //array (or typed array) of elements from GetPropIndex and length of list (-1 if it's unknown);
+    //range isn't cached, if callback doesn't call it
+    procedure SetRangeResult(values: IBaseValue; length: integer); virtual; stdcall; abstract;
   end;
 
   ISetterArgs = class (IEngineIntf)
@@ -158,6 +222,9 @@ type
     procedure SetResult(val: IBaseValue); overload; virtual; stdcall; abstract;
 
     procedure SetError(errorType: PAnsiChar); virtual; stdcall; abstract;
+    //id from IObjectTemplate.SetPropWithId/SetFieldWithId (-1 if there is no id)
+    function GetPropId: integer; virtual; stdcall; abstract;
+    function GetValueAsUnicodeString(buf: PWideChar; len: integer): integer; virtual; stdcall; abstract;
   end;
 
   IIntfSetterArgs = class (IEngineIntf)
@@ -181,6 +248,16 @@ type
   TIntfSetterCallBack = procedure(args: IIntfSetterArgs); stdcall;
   TErrorMsgCallBack = procedure(errMsg: PAnsiChar; eng: TObject); stdcall;
   TClassTypeChecker = function(cType: TClass; eng: TObject): TClass; stdcall;
+  TObjectCollectedCallBack = procedure(obj: TObject; cType: TClass; eng: TObject); stdcall;
+
+  THeapStatistics = record
+    TotalHeapSize: Int64;
+    TotalHeapSizeExecutable: Int64;
+    TotalPhysicalSize: Int64;
+    TotalAvailableSize: Int64;
+    UsedHeapSize: Int64;
+    HeapSizeLimit: Int64;
+  end;
 
   IObjectProp = class(IEngineIntf)
     procedure SetRead(read: boolean); virtual; stdcall; abstract;
@@ -196,6 +273,9 @@ type
     procedure SetEnumField(fieldName: PAnsiChar; fieldValue: Integer); virtual; stdcall; abstract;
     procedure SetHasIndexedProps(HAsIndexedProps: boolean); virtual; stdcall; abstract;
     procedure SetParent(parent: IObjectTemplate);  virtual; stdcall; abstract;
+    procedure SetMethodWithId(methodName: PAnsiChar; MethodCall: Pointer; id: integer); virtual; stdcall; abstract;
+    procedure SetPropWithId(propName: PAnsiChar; propObj: Pointer; read, write: boolean; id: integer); virtual; stdcall; abstract;
+    procedure SetFieldWithId(fieldName: PAnsiChar; id: integer); virtual; stdcall; abstract;
   end;
 
   IEngine = class(IEngineIntf)
@@ -240,6 +320,62 @@ type
     function NewObject(obj: Pointer; dClasstype: Pointer): IObject; virtual; stdcall; abstract;
     function NewInterfaceObject(p: Pointer): IValue; virtual; stdcall; abstract;
 
+    //called when js wrapper of delphi object is collected;
+    //don't call into engine from this callback
+    procedure SetObjectCollectedCallBack(callBack: TObjectCollectedCallBack); virtual; stdcall; abstract;
+    function WrapperCacheSize: integer; virtual; stdcall; abstract;
+    function WrapperCacheHits: Int64; virtual; stdcall; abstract;
+    function WrapperCacheMisses: Int64; virtual; stdcall; abstract;
+    function WrapperCacheEvictions: Int64; virtual; stdcall; abstract;
+    //if copy is false, typed array uses data directly, so it has to live while script can use the array
+    function NewFloat64Array(data: Pointer; len: NativeUInt; copy: boolean): IValue; virtual; stdcall; abstract;
+    function NewInt32Array(data: Pointer; len: NativeUInt; copy: boolean): IValue; virtual; stdcall; abstract;
+    function PrepareCall(funcName: PAnsiChar): IPreparedCall; virtual; stdcall; abstract;
+    //values, made by engine after BeginValueScope (New* values, CallFunc results),
+    //are deleted by matching EndValueScope; detached values aren't deleted
+    procedure BeginValueScope; virtual; stdcall; abstract;
+    procedure EndValueScope; virtual; stdcall; abstract;
+    function ValueCount: integer; virtual; stdcall; abstract;
+    //RunString/RunFile reuse environment of previous run instead of bootstrapping
+    //node again (modules, required by previous scripts, stay cached)
+    procedure SetWarmRun(warm: boolean); virtual; stdcall; abstract;
+    //code cache for include code/files and modules (empty dir disables it)
+    procedure SetCodeCacheDir(dir: PAnsiChar); virtual; stdcall; abstract;
+    function CodeCacheHits: Int64; virtual; stdcall; abstract;
+    function CodeCacheMisses: Int64; virtual; stdcall; abstract;
+    function CodeCacheRejects: Int64; virtual; stdcall; abstract;
+    //TypeScript transpilation output is cached on disk there (and in memory anyway)
+    procedure SetTranspileCacheDir(dir: PAnsiChar); virtual; stdcall; abstract;
+    //threads for transpilation of main .ts module's graph (0 - off, -1 - count of processors)
+    procedure SetTranspileThreads(threads: integer); virtual; stdcall; abstract;
+    //in step mode RunString/RunFile return after script's first tick and
+    //host runs the rest of script by RunFor/PumpOnce (1 - script has more work,
+    //0 - it is finished, -1 - no script is started)
+    procedure SetStepMode(step: boolean); virtual; stdcall; abstract;
+    function RunFor(ms: integer): integer; virtual; stdcall; abstract;
+    function PumpOnce: integer; virtual; stdcall; abstract;
+    //wall and cpu time limits (ms, 0 - no limit) of every run/step call;
+    //script is interrupted with error code 1001, when one of them is over
+    procedure SetRunLimits(wallMs, cpuMs: integer); virtual; stdcall; abstract;
+    //can be called from any thread
+    procedure Interrupt; virtual; stdcall; abstract;
+    procedure GetHeapStatistics(out stats: THeapStatistics); virtual; stdcall; abstract;
+    //full gc, which frees as much memory as possible
+    procedure LowMemoryNotification; virtual; stdcall; abstract;
+    //shape, registered for key (e.g. PTypeInfo of record); new one is empty
+    function RecordShape(key: Pointer): IRecordShape; virtual; stdcall; abstract;
+    function NewShapedRecord(shape: IRecordShape): IRecord; virtual; stdcall; abstract;
+    //UTF-16 string without conversion to UTF-8 (len without #0)
+    function NewUnicodeString(val: PWideChar; len: integer): IValue; virtual; stdcall; abstract;
+    //profiler of callbacks per registered member (also process.binding('bridge').profile()
+    //for scripts); json lives until next ProfileJSON call
+    procedure SetProfiling(enabled: boolean); virtual; stdcall; abstract;
+    function ProfileJSON: PAnsiChar; virtual; stdcall; abstract;
+    procedure ResetProfile; virtual; stdcall; abstract;
+    //elements of indexed props are got by ranges and cached by engine, so loops over lists
+    //don't call host for every element
+    procedure SetIndexedPropRangeCallBack(callBack: TGetterCallBack); virtual; stdcall; abstract;
+
   end;
 
   function GetMajorVersion: Integer cdecl; external 'node.dll' delayed;
@@ -249,6 +385,20 @@ type
 
   function InitGlobalEngine(DEngine: TObject): IEngine cdecl; external 'node.dll' delayed;
 
+  //snapshot with side effects of plain js source (without node's modules);
+  //result has to be released by FreeStartupSnapshot
+  function CreateStartupSnapshot(source, warmupSource: PAnsiChar;
+    out size: integer): PByte cdecl; external 'node.dll' delayed;
+  procedure FreeStartupSnapshot(data: PByte) cdecl; external 'node.dll' delayed;
+  function InitEngineWithSnapshot(DEngine: TObject; snapshot: PByte;
+    size: integer): IEngine cdecl; external 'node.dll' delayed;
+
+  //heap limits in MB (0 - V8's default); snapshot is optional (nil, 0).
+  //Near the limit host gets error message and, as V8 aborts process when
+  //heap is exhausted, running script is interrupted
+  function InitEngineWithHeapLimits(DEngine: TObject; snapshot: PByte;
+    size: integer; maxOldSpaceMb, maxSemiSpaceMb: integer): IEngine cdecl; external 'node.dll' delayed;
+
   procedure InitializeNode(); cdecl; external 'node.dll' delayed;
   procedure FinalizeNode(); cdecl; external 'node.dll' delayed;
 
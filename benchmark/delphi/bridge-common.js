@@ -0,0 +1,36 @@
+'use strict';
+// Helpers for benchmarks of js <-> delphi bridge.
+// These scripts should be run by delphi host (Delphi/V8EngineProj), e.g.:
+//   V8EngineProj.exe --eval benchmark/delphi/method-calls.js
+// or by native host of the same classes (benchmark/delphi/bridge_bench.cc):
+//   out/Release/bridge_bench benchmark/delphi/method-calls.js
+// because plain node has no registered delphi classes.
+
+exports.hasBridge = function() {
+  return typeof NewSomeObject === 'function';
+};
+
+// benchmark's result is checked, so broken bridge doesn't look fast
+exports.check = function(name, actual, expected) {
+  if (actual !== expected)
+    throw new Error(`delphi/${name}: got ${actual} instead of ${expected}`);
+};
+
+exports.measure = function(name, n, fn) {
+  const start = process.hrtime();
+  fn(n);
+  const time = process.hrtime(start);
+  const seconds = time[0] + time[1] / 1e9;
+  const rate = n / seconds;
+  console.log(`delphi/${name}: ${rate.toFixed(0)} calls/sec (${n} calls)`);
+  return rate;
+};
+
+exports.run = function(benchmarks, n) {
+  if (!exports.hasBridge()) {
+    console.log('delphi bridge is not available, run this script by delphi host or bridge_bench');
+    return;
+  }
+  for (const name of Object.keys(benchmarks))
+    exports.measure(name, n, benchmarks[name]);
+};
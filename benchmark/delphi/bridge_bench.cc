@@ -0,0 +1,721 @@
+// Native host of delphi bridge for benchmarks and regression checks of bridge
+// without delphi (e.g. on linux). It registers classes and globals like
+// Delphi/SampleClasses.pas does (TSomeObject, TSomeAttrObject, TSomeList,
+// TDeepLevel0..5, records and arrays of numbers) through the same exported
+// functions and virtual interfaces as delphi host, so benchmark/delphi scripts
+// run by it unchanged:
+//   out/Release/bridge_bench benchmark/delphi/method-calls.js
+// Options:
+//   --profile     print profile of bridge callbacks after the script
+//   --no-ranges   don't give elements of indexed properties by ranges
+// Exit code is non-zero if script fails or engine reports any error.
+
+#include "delphi_intf.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bridge_bench {
+
+using Bv8::IEngine;
+using Bv8::IGetterArgs;
+using Bv8::IIntfSetterArgs;
+using Bv8::IMethodArgs;
+using Bv8::IObject;
+using Bv8::IObjectTemplate;
+using Bv8::IRecord;
+using Bv8::ISetterArgs;
+using Bv8::IValue;
+using Bv8::IValueArray;
+
+class Host;
+struct HostObject;
+
+// bridge's interfaces take names as char *, but don't change them
+inline char* Str(const char* s) {
+  return const_cast<char*>(s);
+}
+
+// classtype slot of wrapper holds either class of object or indexed property
+// (for objects of indexed properties), kind tells them apart
+struct ClassSlot {
+  enum Kind { kClass, kIndexedProp };
+  explicit ClassSlot(Kind kind) : kind(kind) {}
+  Kind kind;
+};
+
+struct HostClass : ClassSlot {
+  HostClass(const char* name, HostClass* parent)
+      : ClassSlot(kClass), name(name), parent(parent) {}
+  const char* name;
+  HostClass* parent;
+  IObjectTemplate* templ = nullptr;
+};
+
+struct IndexedProp : ClassSlot {
+  explicit IndexedProp(const char* name)
+      : ClassSlot(kIndexedProp), name(name) {}
+  const char* name;
+};
+
+struct HostObject {
+  explicit HostObject(HostClass* cls) : cls(cls) {}
+  virtual ~HostObject() {}
+  HostClass* cls;
+};
+
+struct SomeObject : HostObject {
+  explicit SomeObject(HostClass* cls) : HostObject(cls) {}
+  double value = 0;
+};
+
+struct SomeList : HostObject {
+  explicit SomeList(HostClass* cls) : HostObject(cls) {}
+  ~SomeList() override {
+    for (auto item : items)
+      delete item;
+  }
+  std::vector<SomeObject*> items;
+};
+
+struct DeepObject : HostObject {
+  DeepObject(HostClass* cls, int level) : HostObject(cls), level(level) {}
+  int level;
+  int values[6] = {};
+};
+
+typedef void (*MethodFn)(Host* host, HostObject* self, IMethodArgs* args);
+typedef void (*GetterFn)(Host* host, HostObject* self, IGetterArgs* args);
+typedef void (*SetterFn)(Host* host, HostObject* self, ISetterArgs* args);
+
+struct Prop {
+  GetterFn get;
+  SetterFn set;
+};
+
+class Host {
+ public:
+  Host()
+      : global_class_("TGlobalNamespace", nullptr),
+        some_object_("TSomeObject", nullptr),
+        attr_object_("TSomeAttrObject", nullptr),
+        some_list_("TSomeList", nullptr),
+        deep_{ {"TDeepLevel0", nullptr},
+               {"TDeepLevel1", &deep_[0]},
+               {"TDeepLevel2", &deep_[1]},
+               {"TDeepLevel3", &deep_[2]},
+               {"TDeepLevel4", &deep_[3]},
+               {"TDeepLevel5", &deep_[4]} },
+        list_items_("Items") {}
+
+  bool Init(bool ranges);
+  char* Run(const char* script, const char* exe);
+  void PrintStats(bool profile);
+  void Release();
+
+  IEngine* engine() { return engine_; }
+  int errors() const { return errors_; }
+
+ private:
+  void RegisterGlobals();
+  void RegisterClass(HostClass* cls);
+  void AddMethod(IObjectTemplate* templ, const char* name, MethodFn fn);
+  void AddProp(IObjectTemplate* templ, const char* name, GetterFn get,
+               SetterFn set);
+
+  static Host* From(void* dEngine) { return static_cast<Host*>(dEngine); }
+  void ReturnObject(IMethodArgs* args, HostObject* obj) {
+    owned_[obj] = obj->cls;
+    args->SetReturnValueClass(obj, obj->cls);
+  }
+  static SomeList* ListOf(IGetterArgs* args);
+  static SomeObject* ObjectArg(IValue* arg);
+
+  // callbacks of bridge
+  static void APIENTRY MethodCall(IMethodArgs* args);
+  static void APIENTRY PropGetter(IGetterArgs* args);
+  static void APIENTRY PropSetter(ISetterArgs* args);
+  static void APIENTRY FieldGetter(IGetterArgs* args);
+  static void APIENTRY FieldSetter(ISetterArgs* args);
+  static void APIENTRY IndexedObjGetter(IGetterArgs* args);
+  static void APIENTRY IndexedGetter(IGetterArgs* args);
+  static void APIENTRY IndexedSetter(ISetterArgs* args);
+  static void APIENTRY IndexedRange(IGetterArgs* args);
+  static void APIENTRY NamedGetter(IGetterArgs* args);
+  static void APIENTRY NamedSetter(ISetterArgs* args);
+  static void APIENTRY InterfaceGetter(IGetterArgs* args);
+  static void APIENTRY InterfaceSetter(IIntfSetterArgs* args);
+  static void APIENTRY InterfaceMethod(IMethodArgs* args);
+  static void APIENTRY ErrorMessage(const char* errMsg, void* dEngine);
+  static void* APIENTRY ClassTypeChecker(void* classType, void* dEngine);
+  static void APIENTRY ObjectCollected(void* dObj, void* classType,
+                                       void* dEngine);
+
+  // members of registered classes
+  static void NewSomeObject(Host* host, HostObject* self, IMethodArgs* args);
+  static void NewAttrObject(Host* host, HostObject* self, IMethodArgs* args);
+  static void NewSomeList(Host* host, HostObject* self, IMethodArgs* args);
+  static void NewDeepObject(Host* host, HostObject* self, IMethodArgs* args);
+  static void NewDeepLeaf(Host* host, HostObject* self, IMethodArgs* args);
+  static void NewVector(Host* host, HostObject* self, IMethodArgs* args);
+  static void VLength(Host* host, HostObject* self, IMethodArgs* args);
+  static void SumValues(Host* host, HostObject* self, IMethodArgs* args);
+  static void MakeCoords(Host* host, HostObject* self, IMethodArgs* args);
+  static void MakeTypedCoords(Host* host, HostObject* self, IMethodArgs* args);
+  static void SumCoords(Host* host, HostObject* self, IMethodArgs* args);
+  static void CheckValueScopes(Host* host, HostObject* self,
+                               IMethodArgs* args);
+  static void GetNumber(Host* host, HostObject* self, IMethodArgs* args);
+  static void ListAdd(Host* host, HostObject* self, IMethodArgs* args);
+  static void DeepLevel(Host* host, HostObject* self, IMethodArgs* args);
+  static void DeepBase(Host* host, HostObject* self, IMethodArgs* args);
+  static void GetValue(Host* host, HostObject* self, IGetterArgs* args);
+  static void SetValue(Host* host, HostObject* self, ISetterArgs* args);
+  static void GetCount(Host* host, HostObject* self, IGetterArgs* args);
+  static void GetDeepValue(Host* host, HostObject* self, IGetterArgs* args);
+  static void SetDeepValue(Host* host, HostObject* self, ISetterArgs* args);
+
+  IEngine* engine_ = nullptr;
+  // error messages of engine; script's exception doesn't always set error
+  // code, so any of them fails the run
+  int errors_ = 0;
+  HostObject global_object_{nullptr};
+  HostClass global_class_;
+  HostClass some_object_;
+  HostClass attr_object_;
+  HostClass some_list_;
+  HostClass deep_[6];
+  IndexedProp list_items_;
+  // ids of methods and props, given to bridge, are indexes in these tables
+  std::vector<MethodFn> methods_;
+  std::vector<Prop> props_;
+  // objects, made by script, with their classes; object is deleted when its
+  // wrapper is collected, unless list has taken it. Wrapper may outlive
+  // object (e.g. wrapper of list's Items), so object isn't dereferenced there
+  std::unordered_map<void*, void*> owned_;
+};
+
+bool Host::Init(bool ranges) {
+  engine_ = Bv8::Bazis::InitEngine(this);
+  if (!engine_)
+    return false;
+  engine_->SetMethodCallBack(MethodCall);
+  engine_->SetPropGetterCallBack(PropGetter);
+  engine_->SetPropSetterCallBack(PropSetter);
+  engine_->SetFieldGetterCallBack(FieldGetter);
+  engine_->SetFieldSetterCallBack(FieldSetter);
+  engine_->SetIndexedPropGetterObjCallBack(IndexedObjGetter);
+  engine_->SetIndexedPropGetterNumberCallBack(IndexedGetter);
+  engine_->SetIndexedPropSetterNumberCallBack(IndexedSetter);
+  engine_->SetNamedPropGetterNumberCallBack(NamedGetter);
+  engine_->SetNamedPropSetterNumberCallBack(NamedSetter);
+  engine_->SetInterfaceGetterPropCallBack(InterfaceGetter);
+  engine_->SetInterfaceSetterPropCallBack(InterfaceSetter);
+  engine_->SetInterfaceMethodCallBack(InterfaceMethod);
+  engine_->SetErrorMsgCallBack(ErrorMessage);
+  engine_->SetClassTypeChecker(ClassTypeChecker);
+  engine_->SetObjectCollectedCallBack(ObjectCollected);
+  engine_->SetIndexedPropRangeCallBack(ranges ? IndexedRange : nullptr);
+
+  RegisterGlobals();
+  RegisterClass(&some_object_);
+  AddProp(some_object_.templ, "Value", GetValue, SetValue);
+
+  RegisterClass(&attr_object_);
+  AddMethod(attr_object_.templ, "GetNumber", GetNumber);
+
+  RegisterClass(&some_list_);
+  AddMethod(some_list_.templ, "Add", ListAdd);
+  AddProp(some_list_.templ, "Count", GetCount, nullptr);
+  some_list_.templ->SetIndexedProp(Str(list_items_.name), &list_items_, true,
+                                   true);
+  some_list_.templ->SetHasIndexedProps(true);
+
+  // Level is virtual in delphi, so every class has its own; ValueN are
+  // accessed by one getter and setter, which read index from prop's id
+  static const char* const kValueNames[] =
+      {"Value0", "Value1", "Value2", "Value3", "Value4", "Value5"};
+  for (int i = 0; i < 6; i++) {
+    RegisterClass(&deep_[i]);
+    AddMethod(deep_[i].templ, "Level", DeepLevel);
+    if (i == 0)
+      AddMethod(deep_[i].templ, "Base", DeepBase);
+    AddProp(deep_[i].templ, kValueNames[i], GetDeepValue, SetDeepValue);
+  }
+  return true;
+}
+
+void Host::RegisterGlobals() {
+  IObjectTemplate* global = engine_->AddGlobal(&global_class_, &global_object_);
+  global_class_.templ = global;
+  AddMethod(global, "NewSomeObject", NewSomeObject);
+  AddMethod(global, "NewAttrObject", NewAttrObject);
+  AddMethod(global, "NewSomeList", NewSomeList);
+  AddMethod(global, "NewDeepObject", NewDeepObject);
+  AddMethod(global, "NewDeepLeaf", NewDeepLeaf);
+  AddMethod(global, "NewVector", NewVector);
+  AddMethod(global, "VLength", VLength);
+  AddMethod(global, "SumValues", SumValues);
+  AddMethod(global, "MakeCoords", MakeCoords);
+  AddMethod(global, "MakeTypedCoords", MakeTypedCoords);
+  AddMethod(global, "SumCoords", SumCoords);
+  AddMethod(global, "CheckValueScopes", CheckValueScopes);
+}
+
+void Host::RegisterClass(HostClass* cls) {
+  cls->templ = engine_->AddObject(Str(cls->name), cls);
+  if (cls->parent)
+    cls->templ->SetParent(cls->parent->templ);
+}
+
+void Host::AddMethod(IObjectTemplate* templ, const char* name, MethodFn fn) {
+  templ->SetMethodWithId(Str(name), reinterpret_cast<void*>(fn),
+                         static_cast<int>(methods_.size()));
+  methods_.push_back(fn);
+}
+
+void Host::AddProp(IObjectTemplate* templ, const char* name, GetterFn get,
+                   SetterFn set) {
+  templ->SetPropWithId(Str(name), nullptr, get != nullptr, set != nullptr,
+                       static_cast<int>(props_.size()));
+  props_.push_back({get, set});
+}
+
+char* Host::Run(const char* script, const char* exe) {
+  // engine changes current dir to script's one, so relative path would be
+  // resolved twice
+  char path[4096];
+#ifdef _WIN32
+  if (!_fullpath(path, script, sizeof(path)))
+#else
+  if (!realpath(script, path))
+#endif
+    snprintf(path, sizeof(path), "%s", script);
+  return engine_->RunFile(path, Str(exe), nullptr);
+}
+
+void Host::PrintStats(bool profile) {
+  printf("bridge/wrapper-cache: %lld hits, %lld misses, %lld evictions, "
+         "size %d\n",
+         static_cast<long long>(engine_->WrapperCacheHits()),
+         static_cast<long long>(engine_->WrapperCacheMisses()),
+         static_cast<long long>(engine_->WrapperCacheEvictions()),
+         engine_->WrapperCacheSize());
+  if (profile)
+    printf("bridge/profile: %s\n", engine_->ProfileJSON());
+}
+
+void Host::Release() {
+  if (engine_) {
+    engine_->Delete();
+    engine_ = nullptr;
+  }
+  for (auto& obj : owned_)
+    delete static_cast<HostObject*>(obj.first);
+  owned_.clear();
+}
+
+void APIENTRY Host::MethodCall(IMethodArgs* args) {
+  Host* host = From(args->GetEngine());
+  int id = args->GetMethodId();
+  if (id < 0 || id >= static_cast<int>(host->methods_.size())) {
+    args->SetError(Str("unknown method"));
+    return;
+  }
+  auto self = static_cast<HostObject*>(args->GetDelphiObject());
+  host->methods_[id](host, self, args);
+}
+
+void APIENTRY Host::PropGetter(IGetterArgs* args) {
+  Host* host = From(args->GetEngine());
+  int id = args->GetPropId();
+  if (id < 0 || id >= static_cast<int>(host->props_.size()) ||
+      !host->props_[id].get) {
+    args->SetError(Str("unknown property"));
+    return;
+  }
+  auto self = static_cast<HostObject*>(args->GetDelphiObject());
+  host->props_[id].get(host, self, args);
+}
+
+void APIENTRY Host::PropSetter(ISetterArgs* args) {
+  Host* host = From(args->GetEngine());
+  int id = args->GetPropId();
+  if (id < 0 || id >= static_cast<int>(host->props_.size()) ||
+      !host->props_[id].set) {
+    args->SetError(Str("property is read only"));
+    return;
+  }
+  auto self = static_cast<HostObject*>(args->GetDelphiObject());
+  host->props_[id].set(host, self, args);
+}
+
+// host classes have no fields
+void APIENTRY Host::FieldGetter(IGetterArgs* args) {
+  args->SetGetterResultUndefined();
+}
+
+void APIENTRY Host::FieldSetter(ISetterArgs* args) {
+}
+
+void APIENTRY Host::IndexedObjGetter(IGetterArgs* args) {
+  Host* host = From(args->GetEngine());
+  args->SetGetterResultAsIndexObject(args->GetDelphiObject(),
+                                     &host->list_items_);
+}
+
+// elements of list are got by default indexed property of list and by its
+// Items, so wrapper's classtype is either list's class or Items
+SomeList* Host::ListOf(IGetterArgs* args) {
+  auto slot = static_cast<ClassSlot*>(args->GetDelphiClasstype());
+  auto obj = static_cast<HostObject*>(args->GetDelphiObject());
+  if (!slot || !obj)
+    return nullptr;
+  if (slot->kind == ClassSlot::kClass &&
+      static_cast<HostClass*>(slot) != obj->cls)
+    return nullptr;
+  return static_cast<SomeList*>(obj);
+}
+
+void APIENTRY Host::IndexedGetter(IGetterArgs* args) {
+  SomeList* list = ListOf(args);
+  int index = args->GetPropIndex();
+  if (!list || index < 0 || index >= static_cast<int>(list->items.size())) {
+    args->SetGetterResultUndefined();
+    return;
+  }
+  SomeObject* item = list->items[index];
+  args->SetGetterResultDObject(item, item->cls);
+}
+
+void APIENTRY Host::IndexedSetter(ISetterArgs* args) {
+  Host* host = From(args->GetEngine());
+  auto list = static_cast<SomeList*>(args->GetDelphiObject());
+  int index = args->GetPropIndex();
+  auto item = static_cast<SomeObject*>(args->GetValueAsDObject());
+  if (!list || index < 0 || index >= static_cast<int>(list->items.size()) ||
+      !item) {
+    args->SetError(Str("Argument out of range"));
+    return;
+  }
+  // replaced item goes back to script
+  SomeObject* old = list->items[index];
+  host->owned_[old] = old->cls;
+  host->owned_.erase(item);
+  list->items[index] = item;
+}
+
+void APIENTRY Host::IndexedRange(IGetterArgs* args) {
+  Host* host = From(args->GetEngine());
+  SomeList* list = ListOf(args);
+  int index = args->GetPropIndex();
+  if (!list || index < 0)
+    return;
+  int length = static_cast<int>(list->items.size());
+  int count = args->GetRangeCount();
+  if (index > length)
+    index = length;
+  if (count > length - index)
+    count = length - index;
+  IEngine* engine = host->engine_;
+  engine->BeginValueScope();
+  IValueArray* values = engine->NewArray(count);
+  for (int i = 0; i < count; i++) {
+    SomeObject* item = list->items[index + i];
+    values->SetValue(engine->NewObject(item, item->cls), i);
+  }
+  args->SetRangeResult(values, length);
+  engine->EndValueScope();
+}
+
+void APIENTRY Host::NamedGetter(IGetterArgs* args) {
+  args->SetGetterResultUndefined();
+}
+
+void APIENTRY Host::NamedSetter(ISetterArgs* args) {
+}
+
+// host has no interfaces
+void APIENTRY Host::InterfaceGetter(IGetterArgs* args) {
+  args->SetGetterResultUndefined();
+}
+
+void APIENTRY Host::InterfaceSetter(IIntfSetterArgs* args) {
+}
+
+void APIENTRY Host::InterfaceMethod(IMethodArgs* args) {
+  args->SetReturnValueUndefined();
+}
+
+void APIENTRY Host::ErrorMessage(const char* errMsg, void* dEngine) {
+  From(dEngine)->errors_++;
+  fprintf(stderr, "%s\n", errMsg);
+}
+
+void* APIENTRY Host::ClassTypeChecker(void* classType, void* dEngine) {
+  Host* host = From(dEngine);
+  auto cls = static_cast<HostClass*>(classType);
+  while (cls && !host->engine_->ClassIsRegistered(cls))
+    cls = cls->parent;
+  return cls;
+}
+
+void APIENTRY Host::ObjectCollected(void* dObj, void* classType,
+                                    void* dEngine) {
+  Host* host = From(dEngine);
+  auto it = host->owned_.find(dObj);
+  if (it == host->owned_.end() || it->second != classType)
+    return;
+  host->owned_.erase(it);
+  delete static_cast<HostObject*>(dObj);
+}
+
+void Host::NewSomeObject(Host* host, HostObject* self, IMethodArgs* args) {
+  host->ReturnObject(args, new SomeObject(&host->some_object_));
+}
+
+void Host::NewAttrObject(Host* host, HostObject* self, IMethodArgs* args) {
+  host->ReturnObject(args, new HostObject(&host->attr_object_));
+}
+
+void Host::NewSomeList(Host* host, HostObject* self, IMethodArgs* args) {
+  host->ReturnObject(args, new SomeList(&host->some_list_));
+}
+
+void Host::NewDeepObject(Host* host, HostObject* self, IMethodArgs* args) {
+  int level = args->GetArgsCount() > 0 ? args->GetArg(0)->GetArgAsInt() : 0;
+  if (level < 0 || level > 5) {
+    args->SetError(Str("level is out of range"));
+    return;
+  }
+  host->ReturnObject(args, new DeepObject(&host->deep_[level], level));
+}
+
+void Host::NewDeepLeaf(Host* host, HostObject* self, IMethodArgs* args) {
+  host->ReturnObject(args, new DeepObject(&host->deep_[5], 5));
+}
+
+void Host::NewVector(Host* host, HostObject* self, IMethodArgs* args) {
+  static const char* const kFields[] = {"x", "y", "z"};
+  IRecord* vec = host->engine_->NewRecord();
+  for (int i = 0; i < 3; i++) {
+    double coord = i < args->GetArgsCount() ?
+        args->GetArg(i)->GetArgAsNumber() : 0;
+    vec->SetDoubleField(Str(kFields[i]), coord);
+  }
+  args->SetReturnValue(vec);
+}
+
+void Host::VLength(Host* host, HostObject* self, IMethodArgs* args) {
+  if (args->GetArgsCount() < 1) {
+    args->SetError(Str("vector is expected"));
+    return;
+  }
+  IRecord* vec = args->GetArg(0)->GetArgAsRecord();
+  double x = vec->GetDoubleField(Str("x"));
+  double y = vec->GetDoubleField(Str("y"));
+  double z = vec->GetDoubleField(Str("z"));
+  args->SetReturnValueDouble(sqrt(x * x + y * y + z * z));
+}
+
+// wrapper of object or string, made by its toString()
+SomeObject* Host::ObjectArg(IValue* arg) {
+  IObject* obj = arg->GetArgAsObject();
+  if (!obj)
+    return nullptr;
+  return static_cast<SomeObject*>(obj->GetDelphiObject());
+}
+
+void Host::SumValues(Host* host, HostObject* self, IMethodArgs* args) {
+  if (args->GetArgsCount() < 4) {
+    args->SetError(Str("four objects are expected"));
+    return;
+  }
+  double sum = 0;
+  for (int i = 0; i < 4; i++) {
+    SomeObject* obj = ObjectArg(args->GetArg(i));
+    if (!obj) {
+      args->SetError(Str("object is expected"));
+      return;
+    }
+    sum += obj->value;
+  }
+  args->SetReturnValueDouble(sum);
+}
+
+void Host::MakeCoords(Host* host, HostObject* self, IMethodArgs* args) {
+  int count = args->GetArgsCount() > 0 ? args->GetArg(0)->GetArgAsInt() : 0;
+  IEngine* engine = host->engine_;
+  IValueArray* coords = engine->NewArray(count);
+  for (int i = 0; i < count; i++)
+    coords->SetValue(engine->NewNumber(i), i);
+  args->SetReturnValue(coords);
+}
+
+void Host::MakeTypedCoords(Host* host, HostObject* self, IMethodArgs* args) {
+  int count = args->GetArgsCount() > 0 ? args->GetArg(0)->GetArgAsInt() : 0;
+  std::vector<double> coords(count > 0 ? count : 0);
+  for (size_t i = 0; i < coords.size(); i++)
+    coords[i] = static_cast<double>(i);
+  args->SetReturnValue(
+      host->engine_->NewFloat64Array(coords.data(), coords.size(), true));
+}
+
+void Host::SumCoords(Host* host, HostObject* self, IMethodArgs* args) {
+  if (args->GetArgsCount() < 1) {
+    args->SetError(Str("coordinates are expected"));
+    return;
+  }
+  IValue* arg = args->GetArg(0);
+  double sum = 0;
+  void* data;
+  size_t len;
+  if (arg->GetArgAsTypedArray(&data, &len) == Bv8::TypedArrayFloat64) {
+    auto coords = static_cast<double*>(data);
+    for (size_t i = 0; i < len; i++)
+      sum += coords[i];
+  } else {
+    IValueArray* coords = arg->GetArgAsArray();
+    int count = coords->GetCount();
+    for (int i = 0; i < count; i++)
+      sum += coords->GetValue(i)->AsValue()->GetArgAsNumber();
+  }
+  args->SetReturnValueDouble(sum);
+}
+
+// Calls of js function (name is the first arg) from host with values, made in
+// value scopes, like delphi host does it in loops. Values of every iteration
+// are released by EndValueScope, so neither count of kept values nor heap
+// may grow between rounds; the first round warms up. Returns true if so.
+void Host::CheckValueScopes(Host* host, HostObject* self, IMethodArgs* args) {
+  if (args->GetArgsCount() < 2) {
+    args->SetError(Str("function name and iterations are expected"));
+    return;
+  }
+  IEngine* engine = host->engine_;
+  std::string func = args->GetArg(0)->GetArgAsString();
+  int iterations = args->GetArg(1)->GetArgAsInt();
+  std::string text(100, 'x');
+  const int kRounds = 3;
+  int64_t used[kRounds];
+  int values[kRounds];
+  for (int round = 0; round < kRounds; round++) {
+    for (int i = 0; i < iterations; i++) {
+      engine->BeginValueScope();
+      IValueArray* call_args = engine->NewArray(1);
+      call_args->SetValue(engine->NewString(Str(text.c_str())), 0);
+      bool called = engine->CallFunc(Str(func.c_str()), call_args) != nullptr;
+      engine->EndValueScope();
+      if (!called) {
+        args->SetError(Str("function isn't called"));
+        return;
+      }
+    }
+    engine->LowMemoryNotification();
+    Bv8::HeapStats stats;
+    engine->GetHeapStatistics(&stats);
+    used[round] = stats.usedHeapSize;
+    values[round] = engine->ValueCount();
+  }
+  // heap isn't exactly the same after full gc, leak of iteration's values
+  // would be tens of MB
+  const int64_t kMaxGrowth = 1 << 20;
+  int64_t growth = used[kRounds - 1] - used[1];
+  bool flat = values[kRounds - 1] == values[1] && growth < kMaxGrowth;
+  printf("bridge/value-scopes: %d values, heap %lld -> %lld bytes (%s)\n",
+         values[kRounds - 1], static_cast<long long>(used[1]),
+         static_cast<long long>(used[kRounds - 1]), flat ? "flat" : "grows");
+  args->SetReturnValueBool(flat);
+}
+
+void Host::GetNumber(Host* host, HostObject* self, IMethodArgs* args) {
+  args->SetReturnValueInt(1);
+}
+
+void Host::ListAdd(Host* host, HostObject* self, IMethodArgs* args) {
+  SomeObject* item = args->GetArgsCount() > 0 ?
+      ObjectArg(args->GetArg(0)) : nullptr;
+  if (!item) {
+    args->SetError(Str("object is expected"));
+    return;
+  }
+  // list owns its items
+  host->owned_.erase(item);
+  auto list = static_cast<SomeList*>(self);
+  list->items.push_back(item);
+  args->SetReturnValueInt(static_cast<int>(list->items.size()) - 1);
+}
+
+void Host::DeepLevel(Host* host, HostObject* self, IMethodArgs* args) {
+  args->SetReturnValueInt(static_cast<DeepObject*>(self)->level);
+}
+
+void Host::DeepBase(Host* host, HostObject* self, IMethodArgs* args) {
+  args->SetReturnValueInt(static_cast<DeepObject*>(self)->values[0]);
+}
+
+void Host::GetValue(Host* host, HostObject* self, IGetterArgs* args) {
+  args->SetGetterResultDouble(static_cast<SomeObject*>(self)->value);
+}
+
+void Host::SetValue(Host* host, HostObject* self, ISetterArgs* args) {
+  static_cast<SomeObject*>(self)->value = args->GetValueAsDouble();
+}
+
+void Host::GetCount(Host* host, HostObject* self, IGetterArgs* args) {
+  args->SetGetterResultInt(
+      static_cast<int>(static_cast<SomeList*>(self)->items.size()));
+}
+
+// ValueN is the last char of prop's name
+void Host::GetDeepValue(Host* host, HostObject* self, IGetterArgs* args) {
+  const char* name = args->GetPropName();
+  int n = name[strlen(name) - 1] - '0';
+  args->SetGetterResultInt(static_cast<DeepObject*>(self)->values[n]);
+}
+
+void Host::SetDeepValue(Host* host, HostObject* self, ISetterArgs* args) {
+  const char* name = args->GetPropName();
+  int n = name[strlen(name) - 1] - '0';
+  static_cast<DeepObject*>(self)->values[n] = args->GetValueAsInt();
+}
+
+}  // namespace bridge_bench
+
+int main(int argc, char* argv[]) {
+  const char* script = nullptr;
+  bool profile = false;
+  bool ranges = true;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--profile") == 0)
+      profile = true;
+    else if (strcmp(argv[i], "--no-ranges") == 0)
+      ranges = false;
+    else if (!script)
+      script = argv[i];
+  }
+  if (!script) {
+    fprintf(stderr, "Usage: %s [--profile] [--no-ranges] <script.js>\n",
+            argv[0]);
+    return 2;
+  }
+
+  bridge_bench::Host host;
+  if (!host.Init(ranges)) {
+    fprintf(stderr, "engine isn't created\n");
+    return 1;
+  }
+  host.engine()->SetProfiling(profile);
+  host.Run(script, argv[0]);
+  host.PrintStats(profile);
+  int exit_code = host.engine()->ErrorCode();
+  if (exit_code == 0 && host.errors() > 0)
+    exit_code = 1;
+  host.Release();
+  return exit_code;
+}
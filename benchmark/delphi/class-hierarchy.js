@@ -0,0 +1,62 @@
+'use strict';
+// Member access on objects of deep delphi class hierarchy (TDeepLevel0..5).
+// NewDeepLeaf returns TDeepLevel5, so the whole hierarchy is registered.
+// Inherited members are one accessor or function on base class' prototype,
+// which is shared by objects of all levels. Each level still has its own map,
+// so the call site, which sees objects of all six levels, is megamorphic.
+const common = require('./bridge-common.js');
+
+const n = 1e6;
+const levels = 6;
+
+function makeObjects() {
+  const objects = [];
+  for (var i = 0; i < levels; i++) {
+    objects.push(NewDeepObject(i));
+    objects[i].Value0 = i;
+  }
+  return objects;
+}
+
+// sum of (i % levels) for i < n: expected result of loops over objects
+function levelSum(n) {
+  const cycle = levels * (levels - 1) / 2;
+  const rest = n % levels;
+  return Math.floor(n / levels) * cycle + rest * (rest - 1) / 2;
+}
+
+common.run({
+  'hierarchy-wrap': function(n) {
+    var obj;
+    for (var i = 0; i < n; i++)
+      obj = NewDeepObject(i % levels);
+    common.check('hierarchy-wrap', obj.Level(), (n - 1) % levels);
+  },
+  'hierarchy-base-method': function(n) {
+    const objects = makeObjects();
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += objects[i % levels].Base();
+    common.check('hierarchy-base-method', sum, levelSum(n));
+  },
+  'hierarchy-virtual-method': function(n) {
+    const objects = makeObjects();
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += objects[i % levels].Level();
+    common.check('hierarchy-virtual-method', sum, levelSum(n));
+  },
+  'hierarchy-base-prop': function(n) {
+    const objects = makeObjects();
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += objects[i % levels].Value0;
+    common.check('hierarchy-base-prop', sum, levelSum(n));
+  },
+  'hierarchy-leaf-prop': function(n) {
+    const obj = NewDeepLeaf();
+    for (var i = 0; i < n; i++)
+      obj.Value5 = i;
+    common.check('hierarchy-leaf-prop', obj.Value5, n - 1);
+  }
+}, n);
@@ -0,0 +1,43 @@
+'use strict';
+// Reading of delphi list's elements: by default indexed property (list[i]),
+// by object of indexed property (list.Items[i] with its length) and by for..of.
+// Elements are got from delphi by ranges, so loops don't call it per element.
+const common = require('./bridge-common.js');
+
+const n = 1e5;
+
+var list;
+if (common.hasBridge()) {
+  list = NewSomeList();
+  for (var i = 0; i < n; i++) {
+    const obj = NewSomeObject();
+    obj.Value = i;
+    list.Add(obj);
+  }
+  common.check('list-count', list.Count, n);
+}
+
+var last;
+
+common.run({
+  'list-default-index': function(n) {
+    for (var i = 0; i < n; i++)
+      last = list[i];
+    common.check('list-default-index', last.Value, n - 1);
+  },
+  'list-items-index': function(n) {
+    const items = list.Items;
+    for (var i = 0; i < items.length; i++)
+      last = items[i];
+    common.check('list-items-index', last.Value, n - 1);
+  },
+  'list-items-for-of': function(n) {
+    var count = 0;
+    for (const item of list.Items) {
+      last = item;
+      count++;
+    }
+    common.check('list-items-for-of', count, n);
+    common.check('list-items-for-of', last.Value, n - 1);
+  }
+}, n);
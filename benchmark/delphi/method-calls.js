@@ -0,0 +1,36 @@
+'use strict';
+// Calls per second for method, getter and setter callbacks of delphi objects.
+const common = require('./bridge-common.js');
+
+const n = 1e6;
+
+common.run({
+  'method-no-args': function(n) {
+    const obj = NewAttrObject();
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += obj.GetNumber();
+    common.check('method-no-args', sum, n);
+  },
+  'method-record-arg': function(n) {
+    const vec = NewVector(2, 3, 6);
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += VLength(vec);
+    common.check('method-record-arg', sum, 7 * n);
+  },
+  'prop-getter': function(n) {
+    const obj = NewSomeObject();
+    obj.Value = 2;
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += obj.Value;
+    common.check('prop-getter', sum, 2 * n);
+  },
+  'prop-setter': function(n) {
+    const obj = NewSomeObject();
+    for (var i = 0; i < n; i++)
+      obj.Value = i;
+    common.check('prop-setter', obj.Value, n - 1);
+  }
+}, n);
@@ -0,0 +1,31 @@
+'use strict';
+// Heap of engine right after start and size of built-in js sources, which
+// were copied into heap of every isolate before natives became external
+// strings. Compare heap numbers of two builds; --expose-gc makes them exact:
+//   V8EngineProj.exe --eval benchmark/delphi/natives-heap.js --expose-gc
+const v8 = require('v8');
+
+const natives = process.binding('natives');
+var oneByte = 0;
+var twoByte = 0;
+for (const id of Object.keys(natives)) {
+  const source = natives[id];
+  if (typeof source !== 'string')
+    continue;
+  if (/[^\u0000-\u00ff]/.test(source))
+    twoByte += source.length;
+  else
+    oneByte += source.length;
+}
+
+if (typeof gc === 'function')
+  gc();
+const heap = v8.getHeapStatistics();
+const mb = (bytes) => (bytes / 1024 / 1024).toFixed(2);
+
+console.log(`delphi/natives: ${Object.keys(natives).length} sources, ` +
+            `${mb(oneByte + twoByte * 2)} MB ` +
+            `(${mb(twoByte * 2)} MB two-byte)`);
+console.log(`delphi/startup-heap: used ${mb(heap.used_heap_size)} MB, ` +
+            `total ${mb(heap.total_heap_size)} MB`);
+console.log(`delphi/startup-external: ${mb(process.memoryUsage().external || 0)} MB`);
@@ -0,0 +1,39 @@
+'use strict';
+// Calls of delphi method with several delphi objects as arguments.
+// Objects are passed as wrappers or as strings, made by their toString().
+const common = require('./bridge-common.js');
+
+const n = 1e6;
+
+function makeObjects() {
+  const objects = [];
+  for (var i = 0; i < 4; i++) {
+    objects.push(NewSomeObject());
+    objects[i].Value = i;
+  }
+  return objects;
+}
+
+common.run({
+  'object-args': function(n) {
+    const o = makeObjects();
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += SumValues(o[0], o[1], o[2], o[3]);
+    common.check('object-args', sum, 6 * n);
+  },
+  'object-string-args': function(n) {
+    const o = makeObjects().map((obj) => String(obj));
+    var sum = 0;
+    for (var i = 0; i < n; i++)
+      sum += SumValues(o[0], o[1], o[2], o[3]);
+    common.check('object-string-args', sum, 6 * n);
+  },
+  'object-to-string': function(n) {
+    const obj = NewSomeObject();
+    var s;
+    for (var i = 0; i < n; i++)
+      s = String(obj);
+    common.check('object-to-string', typeof s, 'string');
+  }
+}, n);
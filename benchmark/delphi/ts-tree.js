@@ -0,0 +1,58 @@
+'use strict';
+// Start of script tree of .ts modules: first .ts require (it loads bundled
+// compiler) and require of the whole tree. Run it twice by host with
+// CodeCacheDir and TranspileCacheDir set to see warm start:
+//   V8EngineProj.exe --eval benchmark/delphi/ts-tree.js
+// Prefetch (TranspileThreads) works for main module, so to compare it with
+// transpilation on main thread run generated tree's root as main module
+// (<tmpdir>/ts-tree-<modules>/m0.ts) with and without it; prefetchTime
+// against transpileTime in transpile cache counters shows the saving.
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const modules = +process.argv[2] || 200;
+
+if (!require.extensions['.ts']) {
+  console.log('.ts modules are not supported by this node');
+  return;
+}
+
+const dir = path.join(os.tmpdir(), `ts-tree-${modules}`);
+if (!fs.existsSync(dir)) {
+  fs.mkdirSync(dir);
+  for (var i = 0; i < modules; i++) {
+    const deps = [];
+    for (var j = 2 * i + 1; j <= 2 * i + 2 && j < modules; j++)
+      deps.push(`import * as m${j} from './m${j}';`);
+    const body = deps.join('\n') + `
+interface Point${i} { x: number; y: number; }
+export function length${i}(p: Point${i}): number {
+  return Math.sqrt(p.x * p.x + p.y * p.y);
+}
+export const id: number = ${i};
+`;
+    fs.writeFileSync(path.join(dir, `m${i}.ts`), body);
+  }
+}
+
+function ms(time) {
+  return (time[0] * 1e3 + time[1] / 1e6).toFixed(1);
+}
+
+// leaf module first: it is transpiled alone, so its time is mostly
+// loading of compiler
+var start = process.hrtime();
+require(path.join(dir, `m${modules - 1}.ts`));
+const first = process.hrtime(start);
+
+start = process.hrtime();
+require(path.join(dir, 'm0.ts'));
+const tree = process.hrtime(start);
+
+console.log(`delphi/ts-tree-first-require: ${ms(first)} ms`);
+console.log(`delphi/ts-tree-require: ${ms(tree)} ms (${modules} modules)`);
+if (process._tsCacheStats)
+  console.log('transpile cache:', JSON.stringify(process._tsCacheStats));
+if (process._codeCacheStats)
+  console.log('code cache:', JSON.stringify(process._codeCacheStats));
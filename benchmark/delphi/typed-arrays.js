@@ -0,0 +1,40 @@
+'use strict';
+// Numeric arrays passed between delphi and js as plain arrays and as typed arrays.
+const common = require('./bridge-common.js');
+
+const n = 1e4;
+const len = 3000;
+const sum = len * (len - 1) / 2;
+
+common.run({
+  'array-to-delphi': function(n) {
+    const coords = [];
+    for (var i = 0; i < len; i++)
+      coords.push(i);
+    var result;
+    for (var i = 0; i < n; i++)
+      result = SumCoords(coords);
+    common.check('array-to-delphi', result, sum);
+  },
+  'float64array-to-delphi': function(n) {
+    const coords = new Float64Array(len);
+    for (var i = 0; i < len; i++)
+      coords[i] = i;
+    var result;
+    for (var i = 0; i < n; i++)
+      result = SumCoords(coords);
+    common.check('float64array-to-delphi', result, sum);
+  },
+  'array-from-delphi': function(n) {
+    var coords;
+    for (var i = 0; i < n; i++)
+      coords = MakeCoords(len);
+    common.check('array-from-delphi', coords[len - 1], len - 1);
+  },
+  'float64array-from-delphi': function(n) {
+    var coords;
+    for (var i = 0; i < n; i++)
+      coords = MakeTypedCoords(len);
+    common.check('float64array-from-delphi', coords[len - 1], len - 1);
+  }
+}, n);
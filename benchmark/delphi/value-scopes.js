@@ -0,0 +1,18 @@
+'use strict';
+// Values, made by host in Begin/EndValueScope around its calls of js function,
+// must be released at the end of scope: count of kept values and heap stay
+// the same between rounds of calls. Check is done by bridge_bench only:
+//   out/Release/bridge_bench benchmark/delphi/value-scopes.js
+const n = 1e5;
+
+if (typeof CheckValueScopes !== 'function') {
+  console.log('value scopes are checked by bridge_bench only');
+  return;
+}
+
+global.bridgeBenchEcho = function(s) {
+  return s;
+};
+
+if (!CheckValueScopes('bridgeBenchEcho', n))
+  throw new Error('values of host calls are kept after the end of scope');
@@ -49,6 +49,9 @@
       _process.setupChannel();
 
     _process.setupRawDebug();
+    setupWarmRun();
+    NativeModule.require('internal/code_cache').setup();
+    NativeModule.require('internal/ts_cache').setup();
 
     process.argv[0] = process.execPath;
 
@@ -293,8 +296,7 @@
     ////compile source if it's typescript file       
     var body = process._eval;
     if (path.extname(module.filename).toLowerCase() === '.ts'){ 
-      var ts = NativeModule.require('tsserverlibrary');
-      body = ts.transpileModule(body, {
+      body = NativeModule.require('internal/ts_cache').transpile(body, name, {
                                         compilerOptions: {
                                           inlineSourceMap: true,
                                           noImplicitUseStrict: true
@@ -306,19 +308,37 @@
                    'global.exports = exports;\n' +
                    'global.module = module;\n' +
                    'global.__dirname = __dirname;\n' +
-                   'global.require = require;\n' +
-                   'return require("vm").runInThisContext(' +
-                   `${JSON.stringify(body)}, { filename: ` +
-                   `${JSON.stringify(name)}, displayErrors: true });\n`;
+                   'global.require = require;\n';
     // Defer evaluation for a tick.  This is a workaround for deferred
     // events not firing when evaluating scripts from the command line,
     // see https://github.com/nodejs/node/issues/1600.
     process.nextTick(function() {
-      const result = module._compile(script, `${name}-wrapper`);
+      module._compile(script, `${name}-wrapper`);
+      // body itself is compiled with code cache (if embedder enabled it)
+      const result = NativeModule.require('internal/code_cache')
+        .runInThisContext(body, { filename: name, displayErrors: true });
       if (process._print_eval) console.log(result);
     });
   }
 
+  // Used by embedder to run one more entry script in this environment
+  // without bootstrapping it again. Module cache is kept, so only the entry
+  // script itself is evaluated again (in a new module).
+  function setupWarmRun() {
+    process._runWarmScript = function(name, body, isFile) {
+      if (isFile) {
+        const Module = NativeModule.require('module');
+        const filename = Module._resolveFilename(name, null);
+        delete Module._cache[filename];
+        process.argv[1] = filename;
+        Module._load(filename, null, true);
+      } else {
+        process._eval = body;
+        evalScript(name);
+      }
+    };
+  }
+
   // Load preload modules
   function preloadModules() {
     if (process._preload_modules) {
@@ -442,6 +462,11 @@
     '\n});'
   ];
 
+  // Large built-in modules (e.g. tsserverlibrary) are compiled with code cache,
+  // if embedder enabled it. They are loaded after bootstrap, so code cache
+  // module can be required then.
+  const kCodeCachedNativeLength = 256 * 1024;
+
   NativeModule.prototype.compile = function() {
     var source = NativeModule.getSource(this.id);
     source = NativeModule.wrap(source);
@@ -449,11 +474,20 @@
     this.loading = true;
 
     try {
-      var fn = runInThisContext(source, {
+      const options = {
         filename: this.filename,
         lineOffset: 0,
         displayErrors: true
-      });
+      };
+      var fn;
+      if (process._codeCacheDir && source.length >= kCodeCachedNativeLength) {
+        // source is built into binary, so it is identified without hashing
+        const key = `native:${this.id}:${process.version}:${source.length}`;
+        fn = NativeModule.require('internal/code_cache')
+          .runInThisContext(source, options, key);
+      } else {
+        fn = runInThisContext(source, options);
+      }
       fn(this.exports, NativeModule.require, this, this.filename);
 
       this.loaded = true;
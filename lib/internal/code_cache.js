@@ -0,0 +1,104 @@
+'use strict';
+
+// On-disk cache of compiled code for modules. It is enabled by embedder,
+// which sets process._codeCacheDir before bootstrap. Cache file name is hash
+// of V8 version and source, data rejected by V8 is removed and made again
+// by next compilation.
+
+const vm = require('vm');
+const fs = require('fs');
+const path = require('path');
+
+// small scripts are compiled faster than cache file is read
+const kMinSourceLength = 1024;
+
+const stats = { hits: 0, misses: 0, rejects: 0 };
+
+var crypto;
+
+function cacheFile(dir, source) {
+  if (crypto === undefined) {
+    try {
+      crypto = require('crypto');
+    } catch (e) {
+      // built without openssl
+      crypto = null;
+    }
+  }
+  if (crypto === null)
+    return null;
+  const hash = crypto.createHash('sha1');
+  hash.update(process.versions.v8);
+  hash.update('\0');
+  hash.update(source, 'utf8');
+  return path.join(dir, hash.digest('hex') + '.v8cache');
+}
+
+function writeCache(file, data) {
+  // other engines mustn't read half-written file; engines of one process
+  // share pid and can write the same key in the same millisecond
+  const tmp = `${file}.${process.pid}.${Date.now()}.` +
+              `${Math.random().toString(36).slice(2)}.tmp`;
+  try {
+    fs.writeFileSync(tmp, data);
+    fs.renameSync(tmp, file);
+  } catch (e) {
+    try {
+      fs.unlinkSync(tmp);
+    } catch (e) {}
+  }
+}
+
+// compiles source as vm.Script using code cache if it is enabled;
+// cacheKey can be set instead of hashing source (e.g. for built-in modules)
+function compile(source, options, cacheKey) {
+  const dir = process._codeCacheDir;
+  const file = dir && source.length >= kMinSourceLength ?
+      cacheFile(dir, cacheKey || source) : null;
+  if (!file)
+    return new vm.Script(source, options);
+
+  var cachedData;
+  try {
+    cachedData = fs.readFileSync(file);
+  } catch (e) {}
+
+  const scriptOptions = Object.assign({}, options);
+  if (cachedData)
+    scriptOptions.cachedData = cachedData;
+  else
+    scriptOptions.produceCachedData = true;
+  const script = new vm.Script(source, scriptOptions);
+
+  if (cachedData) {
+    if (script.cachedDataRejected) {
+      stats.rejects++;
+      try {
+        fs.unlinkSync(file);
+      } catch (e) {}
+    } else {
+      stats.hits++;
+    }
+  } else {
+    stats.misses++;
+    if (script.cachedDataProduced)
+      writeCache(file, script.cachedData);
+  }
+  return script;
+}
+
+function runInThisContext(source, options, cacheKey) {
+  return compile(source, options, cacheKey).runInThisContext(options);
+}
+
+function setup() {
+  if (process._codeCacheDir)
+    process._codeCacheStats = stats;
+}
+
+module.exports = {
+  compile,
+  runInThisContext,
+  setup,
+  stats
+};
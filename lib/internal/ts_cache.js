@@ -0,0 +1,187 @@
+'use strict';
+
+// Cache of TypeScript transpilation output. Output is kept in memory and,
+// if embedder set process._tsCacheDir, on disk, so unchanged sources are not
+// transpiled again. Key is hash of source, file name, compiler options and
+// bundled compiler.
+
+const NativeModule = require('native_module');
+const fs = require('fs');
+const path = require('path');
+
+// outputs have inline source maps and warm runs keep environment alive, so
+// memory cache keeps only recently used ones (Map iterates in order of
+// insertion, the oldest entry is evicted); the rest are on disk
+const kMaxMemoryEntries = 512;
+const memoryCache = new Map();
+
+// timings are in milliseconds
+const stats = {
+  hits: 0,
+  diskHits: 0,
+  misses: 0,
+  transpileTime: 0,
+  skippedWrites: 0,
+  // filled by prefetch (see internal/ts_prefetch)
+  prefetchedFiles: 0,
+  prefetchThreads: 0,
+  prefetchTime: 0
+};
+
+var crypto;
+var compilerKey;
+
+function hashKey(source, fileName, options) {
+  if (crypto === undefined) {
+    try {
+      crypto = require('crypto');
+    } catch (e) {
+      // built without openssl, only in-memory cache is used
+      crypto = null;
+    }
+  }
+  // bundled compiler changes only with the binary; length of its source
+  // is taken without compiling it
+  if (compilerKey === undefined) {
+    const tsSource = NativeModule.getSource('tsserverlibrary');
+    compilerKey = `${process.version}:${tsSource ? tsSource.length : 0}`;
+  }
+  const optionsKey = `${compilerKey}\0${fileName}\0${JSON.stringify(options)}`;
+  if (crypto === null)
+    return `${optionsKey}\0${source}`;
+  const hash = crypto.createHash('sha1');
+  hash.update(optionsKey);
+  hash.update('\0');
+  hash.update(source, 'utf8');
+  return hash.digest('hex');
+}
+
+function readDisk(key) {
+  const dir = process._tsCacheDir;
+  if (!dir || crypto === null)
+    return undefined;
+  try {
+    return fs.readFileSync(path.join(dir, key + '.js'), 'utf8');
+  } catch (e) {
+    return undefined;
+  }
+}
+
+function writeDisk(key, output) {
+  const dir = process._tsCacheDir;
+  if (!dir || crypto === null)
+    return;
+  const file = path.join(dir, key + '.js');
+  // other engines mustn't read half-written file; engines of one process
+  // share pid and can write the same key in the same millisecond
+  const tmp = `${file}.${process.pid}.${Date.now()}.` +
+              `${Math.random().toString(36).slice(2)}.tmp`;
+  try {
+    fs.writeFileSync(tmp, output);
+    fs.renameSync(tmp, file);
+  } catch (e) {
+    try {
+      fs.unlinkSync(tmp);
+    } catch (e) {}
+  }
+}
+
+function remember(key, output) {
+  memoryCache.delete(key);
+  memoryCache.set(key, output);
+  if (memoryCache.size > kMaxMemoryEntries)
+    memoryCache.delete(memoryCache.keys().next().value);
+}
+
+function lookup(key) {
+  var output = memoryCache.get(key);
+  if (output !== undefined) {
+    stats.hits++;
+    remember(key, output);
+    return output;
+  }
+  output = readDisk(key);
+  if (output !== undefined) {
+    stats.diskHits++;
+    remember(key, output);
+  }
+  return output;
+}
+
+// returns ts.transpileModule(source, options).outputText, taking it from
+// cache when it is possible; result.cached is true then
+function transpile(source, fileName, options) {
+  const key = hashKey(source, fileName, options);
+  var output = lookup(key);
+  if (output !== undefined)
+    return { outputText: output, cached: true };
+
+  stats.misses++;
+  const start = process.hrtime();
+  const ts = NativeModule.require('tsserverlibrary');
+  output = ts.transpileModule(source, options).outputText;
+  const time = process.hrtime(start);
+  stats.transpileTime += time[0] * 1e3 + time[1] / 1e6;
+
+  remember(key, output);
+  writeDisk(key, output);
+  return { outputText: output, cached: false };
+}
+
+// checks cache without counting it as hit
+function has(source, fileName, options) {
+  const key = hashKey(source, fileName, options);
+  return memoryCache.has(key) || readDisk(key) !== undefined;
+}
+
+// puts output, transpiled elsewhere (by prefetch), into cache
+function store(source, fileName, options, output) {
+  const key = hashKey(source, fileName, options);
+  remember(key, output);
+  writeDisk(key, output);
+}
+
+// js file, which is written next to .ts module
+function jsFileName(filename) {
+  const parsed = path.parse(filename);
+  return parsed.dir + '\\' + parsed.name + '.js';
+}
+
+// options of .ts modules, they are a part of cache key,
+// so module loader and prefetch have to use the same ones
+function moduleOptions(filename) {
+  return {
+    fileName: filename,
+    moduleName: jsFileName(filename),
+    compilerOptions: {
+      module: 'commonjs',
+      target: 'es5',
+      project: '.',
+      inlineSourceMap: true
+    }
+  };
+}
+
+// true if file has to be written again: it is absent or older than source
+function isOutdated(outputFile, sourceFile) {
+  try {
+    return fs.statSync(outputFile).mtime < fs.statSync(sourceFile).mtime;
+  } catch (e) {
+    return true;
+  }
+}
+
+function setup() {
+  process._tsCacheStats = stats;
+}
+
+module.exports = {
+  transpile,
+  has,
+  store,
+  jsFileName,
+  moduleOptions,
+  isOutdated,
+  setup,
+  stats
+};
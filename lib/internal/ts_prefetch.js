@@ -0,0 +1,103 @@
+'use strict';
+
+// Prefetch of TypeScript module graph. Files, which are reachable from entry
+// module by static imports and requires with relative paths, are transpiled
+// by worker threads (src/node_ts_prefetch.cc) and put into transpile cache
+// before main thread requires them.
+
+const NativeModule = require('native_module');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const tsCache = require('internal/ts_cache');
+
+// every worker loads compiler itself, so it needs some files to pay for it
+const kMinFilesPerWorker = 8;
+
+const importRe = new RegExp(
+  '(?:\\bimport\\s*(?:[\\w*{}\\s,]+\\s*from\\s*)?|' +
+  '\\bexport\\s*[\\w*{}\\s,]+\\s*from\\s*|' +
+  '\\brequire\\s*\\(\\s*)[\'"]([^\'"]+)[\'"]', 'g');
+
+// packages aren't prefetched, they are usually .js
+function resolveTs(request, dir) {
+  if (!request.startsWith('.') && !path.isAbsolute(request))
+    return null;
+  const base = path.resolve(dir, request);
+  const candidates = [base, base + '.ts', path.join(base, 'index.ts')];
+  for (var i = 0; i < candidates.length; i++) {
+    const file = candidates[i];
+    if (path.extname(file).toLowerCase() !== '.ts')
+      continue;
+    try {
+      if (fs.statSync(file).isFile())
+        return file;
+    } catch (e) {}
+  }
+  return null;
+}
+
+// returns number of transpiled files
+function prefetch(entry, threads) {
+  const start = process.hrtime();
+  const seen = new Set();
+  const queue = [path.resolve(entry)];
+  const files = [];
+  const sources = [];
+  const options = [];
+
+  while (queue.length > 0) {
+    const file = queue.shift();
+    if (seen.has(file))
+      continue;
+    seen.add(file);
+    var source;
+    try {
+      source = fs.readFileSync(file, 'utf8');
+    } catch (e) {
+      continue;
+    }
+    const fileOptions = tsCache.moduleOptions(file);
+    if (!tsCache.has(source, file, fileOptions)) {
+      files.push(file);
+      sources.push(source);
+      options.push(fileOptions);
+    }
+    const dir = path.dirname(file);
+    importRe.lastIndex = 0;
+    var match;
+    while ((match = importRe.exec(source)) !== null) {
+      const dep = resolveTs(match[1], dir);
+      if (dep !== null && !seen.has(dep))
+        queue.push(dep);
+    }
+  }
+
+  var transpiled = 0;
+  if (files.length >= kMinFilesPerWorker) {
+    threads = Math.min(threads || os.cpus().length,
+                       Math.ceil(files.length / kMinFilesPerWorker));
+    const outputs = process.binding('ts_prefetch').transpile(
+      NativeModule.getSource('tsserverlibrary'),
+      sources,
+      options.map((o) => JSON.stringify(o)),
+      threads);
+    for (var i = 0; i < files.length; i++) {
+      // files, failed there, are transpiled by main thread as usual
+      if (outputs[i] === undefined)
+        continue;
+      tsCache.store(sources[i], files[i], options[i], outputs[i]);
+      transpiled++;
+    }
+    tsCache.stats.prefetchThreads = threads;
+  }
+
+  const time = process.hrtime(start);
+  tsCache.stats.prefetchedFiles += transpiled;
+  tsCache.stats.prefetchTime += time[0] * 1e3 + time[1] / 1e6;
+  return transpiled;
+}
+
+module.exports = {
+  prefetch
+};
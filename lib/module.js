@@ -4,6 +4,8 @@ const NativeModule = require('native_module');
 const util = require('util');
 const internalModule = require('internal/module');
 const internalUtil = require('internal/util');
+const codeCache = require('internal/code_cache');
+const tsCache = require('internal/ts_cache');
 const vm = require('vm');
 const assert = require('assert').ok;
 const fs = require('fs');
@@ -510,7 +512,7 @@ Module.prototype._compile = function(content, filename) {
   // create wrapper function
   var wrapper = Module.wrap(content);
 
-  var compiledWrapper = vm.runInThisContext(wrapper, {
+  var compiledWrapper = codeCache.runInThisContext(wrapper, {
     filename: filename,
     lineOffset: 0,
     displayErrors: true
@@ -553,20 +555,20 @@ Module._extensions['.ts'] = function (module, filename) {
   var content = fs.readFileSync(filename, 'utf8');
   ////compile typescript source
   if (path.extname(filename).toLowerCase() === '.ts') {
-    var ts = NativeModule.require('tsserverlibrary');
-    var newFilename = path.parse(filename);
-    var jsFilename = newFilename.dir + '\\' + newFilename.name + '.js';
-    content = ts.transpileModule(content, {
-      fileName: filename,
-      moduleName: jsFilename,
-      compilerOptions: {
-        module: "commonjs",
-        target: "es5",
-        project: ".",
-        inlineSourceMap: true
-      }
-    }).outputText;             // BOM for utf-8
-    fs.writeFileSync(jsFilename, '\ufeff' + content);
+    var jsFilename = tsCache.jsFileName(filename);
+    // whole module graph of main module is transpiled by worker threads,
+    // if embedder enabled it
+    if (process._tsPrefetchThreads !== undefined && module.id === '.')
+      require('internal/ts_prefetch').prefetch(filename,
+                                               process._tsPrefetchThreads);
+    var result = tsCache.transpile(content, filename,
+                                   tsCache.moduleOptions(filename));
+    content = result.outputText;
+    // js file is written again only if source was changed after it
+    if (!result.cached || tsCache.isOutdated(jsFilename, filename))
+      fs.writeFileSync(jsFilename, '\ufeff' + content); // BOM for utf-8
+    else
+      tsCache.stats.skippedWrites++;
   }
   module._compile(content, jsFilename);
 }
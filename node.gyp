@@ -76,6 +76,7 @@
       'lib/zlib.js',
       'lib/internal/child_process.js',
       'lib/internal/cluster.js',
+      'lib/internal/code_cache.js',
       'lib/internal/freelist.js',
       'lib/internal/linkedlist.js',
       'lib/internal/net.js',
@@ -91,6 +92,8 @@
       'lib/internal/util.js',
       'lib/internal/v8_prof_polyfill.js',
       'lib/internal/v8_prof_processor.js',
+      'lib/internal/ts_cache.js',
+      'lib/internal/ts_prefetch.js',
       'lib/internal/streams/lazy_transform.js',
       'lib/internal/streams/BufferList.js',
       'deps/v8/tools/splaytree.js',
@@ -121,12 +124,53 @@
   },
 
   'targets': [
+    {
+      # delphi bridge is c++14, uses rtti and catches failures of engine
+      # (node::V8Exception), so it is built apart from node core, which
+      # keeps flags of common.gypi
+      'target_name': 'delphi_bridge',
+      'type': 'static_library',
+
+      'include_dirs': [
+        'src',
+        'deps/v8/include',
+        'deps/uv/include',
+      ],
+
+      'sources': [
+        'src/delphi_intf.cpp',
+        'src/delphi_intf.h',
+      ],
+
+      'defines': [
+        'NODE_WANT_INTERNALS=1',
+        'V8_DEPRECATION_WARNINGS=1',
+      ],
+
+      'conditions': [
+        [ 'node_shared=="true"', {
+          'defines': [
+            'NODE_SHARED_MODE',
+          ],
+        }],
+        [ 'OS!="win"', {
+          'cflags_cc!': [ '-std=gnu++0x', '-fno-rtti', '-fno-exceptions' ],
+          'cflags_cc': [ '-std=gnu++14', '-frtti', '-fexceptions' ],
+          'xcode_settings': {
+            'CLANG_CXX_LANGUAGE_STANDARD': 'gnu++14',
+            'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',
+            'GCC_ENABLE_CPP_RTTI': 'YES',
+          },
+        }],
+      ],
+    },
     {
       'target_name': '<(node_core_target_name)',
       'type': '<(node_target_type)',
 
       'dependencies': [
         'node_js2c#host',
+        'delphi_bridge',
       ],
 
       'include_dirs': [
@@ -138,7 +182,6 @@
 
       'sources': [
         'src/debug-agent.cc',
-        'src/delphi_intf.cpp',
         'src/async-wrap.cc',
         'src/env.cc',
         'src/fs_event_wrap.cc',
@@ -156,6 +199,7 @@
         'src/node_main.cc',
         'src/node_os.cc',
         'src/node_revert.cc',
+        'src/node_ts_prefetch.cc',
         'src/node_util.cc',
         'src/node_v8.cc',
         'src/node_stat_watcher.cc',
@@ -180,7 +224,6 @@
         'src/base-object.h',
         'src/base-object-inl.h',
         'src/debug-agent.h',
-        'src/delphi_intf.h',
         'src/env.h',
         'src/env-inl.h',
         'src/handle_wrap.h',
@@ -866,6 +909,12 @@
             'deps/v8/tools/gyp/v8.gyp:v8_libplatform'
           ],
         }],
+        # engine of delphi bridge is exported by node library
+        [ 'node_target_type!="executable"', {
+          'dependencies': [ '<(node_core_target_name)' ],
+          'include_dirs': [ 'deps/uv/include' ],
+          'sources': [ 'test/cctest/test_delphi_value_scopes.cc' ],
+        }],
       ]
     }
   ], # end targets
@@ -916,5 +965,26 @@
         }
       ], # end targets
     }], # end aix section
+    # native host of delphi bridge, it runs benchmark/delphi scripts without
+    # delphi. Node has to be built as library (configure --shared or
+    # --enable-static)
+    ['node_target_type!="executable"', {
+      'targets': [
+        {
+          'target_name': 'bridge_bench',
+          'type': 'executable',
+          'dependencies': ['<(node_core_target_name)'],
+
+          'include_dirs': [
+            'src',
+            'deps/v8/include',
+          ],
+
+          'sources': [
+            'benchmark/delphi/bridge_bench.cc',
+          ],
+        },
+      ], # end targets
+    }], # end bridge_bench section
   ], # end conditions block
 }
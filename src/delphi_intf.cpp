@@ -1,15 +1,158 @@
 #include "delphi_intf.h"
+#include "uv.h"
 
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <streambuf>
-#include <regex>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <atomic>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 namespace Bv8 {
 
 const char * dObjectToStringDelimiter = " ";
 const int dObjectToStringDelimiterLength = 1;
+const char * dObjectToStringPrefix = "[object ";
+//max length of string, which can be parsed back to delphi object
+const int dObjectStringMaxLength = 512;
+
+//writes property name to reusable buffer (without allocation, if buffer is big enough)
+static void WritePropName(v8::Local<v8::Name> property, std::string & buffer)
+{
+	if (property->IsString()) {
+		auto str = property.As<v8::String>();
+		int length = str->Utf8Length();
+		buffer.resize(length);
+		str->WriteUtf8(&buffer[0], length, nullptr, v8::String::NO_NULL_TERMINATION);
+	}
+	else {
+		v8::String::Utf8Value str(property);
+		buffer.assign(*str, str.length());
+	}
+}
+
+//host's conversion of object to string runs its toString(), which can read indexed
+//props after host has changed them, so it starts new script epoch
+static void InvalidateForConversion(v8::Isolate * iso, v8::Local<v8::Value> val)
+{
+	if (val.IsEmpty() || !val->IsObject())
+		return;
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (engine)
+		engine->BumpScriptEpoch();
+}
+
+//strings of host's native UTF-16 are written straight to its buffer: no UTF-8 conversion
+//and no intermediate copy. Returns length of string; only length is taken, if buf is nullptr.
+//Host asks again with larger buffer, if string doesn't fit, so converted string is kept for it
+static int WriteUnicode(v8::Isolate * iso, v8::Local<v8::Value> val, uint16_t * buf, int len)
+{
+	if (val.IsEmpty())
+		return 0;
+	IEngine * engine = IEngine::GetEngine(iso);
+	v8::Local<v8::String> str;
+	if (val->IsString())
+		str = val.As<v8::String>();
+	else if (!engine || !engine->TakeUnicodeConversion(val, &str)) {
+		InvalidateForConversion(iso, val);
+		if (!val->ToString(iso->GetCurrentContext()).ToLocal(&str))
+			return 0;
+	}
+	int length = str->Length();
+	if (buf && len > 0)
+		str->Write(buf, 0, len, v8::String::NO_NULL_TERMINATION);
+	if (engine && !val->IsString() && (!buf || len < length))
+		engine->KeepUnicodeConversion(val, str);
+	return length;
+}
+
+//copy of host's string, which is kept out of V8's heap
+class UnicodeStringResource : public v8::String::ExternalStringResource {
+public:
+	UnicodeStringResource(const uint16_t * val, size_t len) : data_(val, val + len) {};
+	const uint16_t * data() const override { return data_.data(); };
+	size_t length() const override { return data_.size(); };
+private:
+	std::vector<uint16_t> data_;
+};
+
+//large strings become external ones: they aren't copied again by gc
+const int kExternalUnicodeLength = 64 * 1024;
+
+static v8::Local<v8::String> NewUnicodeString(v8::Isolate * iso, const uint16_t * val, int len)
+{
+	if (!val || len <= 0)
+		return v8::String::Empty(iso);
+	v8::Local<v8::String> result;
+	if (len >= kExternalUnicodeLength &&
+		v8::String::NewExternalTwoByte(iso, new UnicodeStringResource(val, len)).ToLocal(&result))
+		return result;
+	return v8::String::NewFromTwoByte(iso, val, v8::NewStringType::kNormal, len).ToLocalChecked();
+}
+
+//returns id of object template's member, which was saved to accessor's data
+static int GetMemberId(v8::Local<v8::Value> data)
+{
+	if (data->IsExternal()) {
+		auto prop = static_cast<IObjectProp *>(data.As<v8::External>()->Value());
+		if (prop)
+			return prop->id;
+	}
+	return -1;
+}
+
+//js wrapper of delphi object is branded by external value in its internal field
+static bool IsDelphiWrapper(v8::Local<v8::Value> value)
+{
+	if (!value->IsObject())
+		return false;
+	auto obj = value.As<v8::Object>();
+	return obj->InternalFieldCount() > DelphiObjectIndex && obj->GetInternalField(DelphiObjectIndex)->IsExternal();
+}
+
+//parses string, made by IEngine::toStringCallBack: "[object ClassName] <object> <classtype>"
+static bool ParseObjectString(v8::Local<v8::String> str, uintptr_t & dObject, uintptr_t & dClasstype)
+{
+	int length = str->Length();
+	if (length > dObjectStringMaxLength || !str->ContainsOnlyOneByte())
+		return false;
+	char buffer[dObjectStringMaxLength + 1];
+	str->WriteOneByte(reinterpret_cast<uint8_t *>(buffer), 0, length, v8::String::NO_NULL_TERMINATION);
+	buffer[length] = 0;
+	auto start = strstr(buffer, dObjectToStringPrefix);
+	if (!start)
+		return false;
+	auto pos = strchr(start, ']');
+	if (!pos)
+		return false;
+	char * end = nullptr;
+	dObject = uintptr_t(strtoull(pos + 1, &end, 10));
+	if (end == pos + 1)
+		return false;
+	pos = end;
+	dClasstype = uintptr_t(strtoull(pos, &end, 10));
+	return (end != pos) && dObject;
+}
+
+//class templates' accessors are set to prototype, so holder is the prototype there
+//and wrapper of delphi object is the receiver
+template <class T>
+static v8::Local<v8::Object> WrapperHolder(const v8::PropertyCallbackInfo<T>& info)
+{
+	auto holder = info.Holder();
+	if (holder->InternalFieldCount() > 0)
+		return holder;
+	return info.This();
+}
 
 
 namespace Bazis {
@@ -36,6 +179,43 @@ namespace Bazis {
 		}
 	}
 
+	BZINTF char *BZDECL CreateStartupSnapshot(char * source, char * warmupSource, int * size)
+	{
+		InitializeNode();
+		auto blob = node::CreateStartupSnapshot(source, warmupSource);
+		if (size)
+			*size = blob.raw_size;
+		return const_cast<char *>(blob.data);
+	}
+
+	BZINTF void BZDECL FreeStartupSnapshot(char * data)
+	{
+		delete[] data;
+	}
+
+	BZINTF IEngine *BZDECL InitEngineWithSnapshot(void * DEngine, char * snapshot, int size)
+	{
+		try {
+			InitializeNode();
+			return new IEngine(DEngine, snapshot, size);
+		}
+		catch (node::V8Exception &e) {
+			return nullptr;
+		}
+	}
+
+	BZINTF IEngine *BZDECL InitEngineWithHeapLimits(void * DEngine, char * snapshot, int size,
+		int maxOldSpaceMb, int maxSemiSpaceMb)
+	{
+		try {
+			InitializeNode();
+			return new IEngine(DEngine, snapshot, size, maxOldSpaceMb, maxSemiSpaceMb);
+		}
+		catch (node::V8Exception &e) {
+			return nullptr;
+		}
+	}
+
 	IEngine * global_engine = nullptr;
 
 	BZINTF IEngine *BZDECL InitGlobalEngine(void * DEngine)
@@ -50,8 +230,12 @@ namespace Bazis {
 		}
 	}
 
+    // engines can be created by different threads (e.g. engine pool of host)
+    std::mutex nodeInitMutex;
+
     BZINTF void BZDECL InitializeNode()
     {
+        std::lock_guard<std::mutex> lock(nodeInitMutex);
         if (!nodeInitialized) {
             std::vector<char *> args;
             args.push_back("");
@@ -78,6 +262,197 @@ namespace Bazis {
     } finalizeer;
 }
 
+void ICodeCache::SetDir(const char * dir)
+{
+	this->dir = dir ? dir : "";
+	if (!this->dir.empty() && this->dir.back() != '\\' && this->dir.back() != '/')
+		this->dir += '/';
+}
+
+std::string ICodeCache::FileName(const char * sourceData, size_t sourceLength)
+{
+	// FNV-1a of V8 version and source
+	uint64_t hash = 14695981039346656037ULL;
+	auto add = [&hash](const char * data, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			hash ^= uint8_t(data[i]);
+			hash *= 1099511628211ULL;
+		}
+	};
+	auto version = v8::V8::GetVersion();
+	add(version, strlen(version));
+	add(sourceData, sourceLength);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.v8cache", (unsigned long long)hash);
+	return dir + name;
+}
+
+v8::MaybeLocal<v8::Script> ICodeCache::Compile(v8::Local<v8::Context> context, v8::Local<v8::String> source,
+	v8::ScriptOrigin * origin, const char * sourceData, size_t sourceLength)
+{
+	if (!Enabled() || sourceLength < MinSourceLength)
+		return v8::Script::Compile(context, source, origin);
+	auto fileName = FileName(sourceData, sourceLength);
+	std::vector<char> data;
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		if (file)
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	if (!data.empty()) {
+		// cached data doesn't own the buffer
+		v8::ScriptCompiler::Source cachedSource(source, *origin, new v8::ScriptCompiler::CachedData(
+			reinterpret_cast<uint8_t *>(data.data()), int(data.size())));
+		auto script = v8::ScriptCompiler::Compile(context, &cachedSource, v8::ScriptCompiler::kConsumeCodeCache);
+		if (cachedSource.GetCachedData()->rejected) {
+			rejects++;
+			remove(fileName.c_str());
+		}
+		else
+			hits++;
+		return script;
+	}
+	misses++;
+	v8::ScriptCompiler::Source newSource(source, *origin);
+	auto script = v8::ScriptCompiler::Compile(context, &newSource, v8::ScriptCompiler::kProduceCodeCache);
+	auto cachedData = newSource.GetCachedData();
+	if (!script.IsEmpty() && cachedData) {
+		// cache is written to temporary file first, so other engines don't read half-written file;
+		// name of it is unique for processes and for engines of one process, even if same address
+		// of cache is reused after another engine is freed
+		static std::atomic<unsigned> tmpCounter(0);
+		auto tmpName = fileName + "." + std::to_string(getpid()) + "." + std::to_string(tmpCounter++) + ".tmp";
+		{
+			std::ofstream file(tmpName, std::ios::binary);
+			file.write(reinterpret_cast<const char *>(cachedData->data), cachedData->length);
+		}
+		if (rename(tmpName.c_str(), fileName.c_str()) != 0)
+			remove(tmpName.c_str());
+	}
+	return script;
+}
+
+static const char * const profileKindNames[IBridgeProfiler::kKindCount] = {
+	"method", "getter", "setter", "fieldGetter", "fieldSetter", "indexedPropObj",
+	"indexedGetter", "indexedSetter", "namedGetter", "namedSetter",
+	"interfaceGetter", "interfaceSetter", "interfaceMethod", "indexedRange"
+};
+
+static void WriteJSONString(std::ostringstream & out, const std::string & str)
+{
+	out << '"';
+	for (char c : str) {
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+			out << ' ';
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+IBridgeProfiler::Scope::Scope(IBridgeProfiler & profiler, Kind kind, v8::Local<v8::Value> data)
+{
+	if (!profiler.enabled)
+		return;
+	this->profiler = &profiler;
+	this->kind = kind;
+	if (!data.IsEmpty() && data->IsExternal())
+		member = data.As<v8::External>()->Value();
+	start = uv_hrtime();
+}
+
+IBridgeProfiler::Scope::~Scope()
+{
+	if (profiler)
+		profiler->Record(member, kind, uv_hrtime() - start, hostTime);
+}
+
+void IBridgeProfiler::Scope::HostCall()
+{
+	if (profiler)
+		hostStart = uv_hrtime();
+}
+
+void IBridgeProfiler::Scope::HostDone()
+{
+	if (profiler)
+		hostTime += uv_hrtime() - hostStart;
+}
+
+void IBridgeProfiler::Record(void * member, Kind kind, uint64_t time, uint64_t hostTime)
+{
+	auto &entry = entries[Key{ member, kind }];
+	entry.calls++;
+	entry.totalNs += time;
+	entry.hostNs += hostTime;
+	if (time > entry.maxNs)
+		entry.maxNs = time;
+	int bucket = 0;
+	while (bucket < kBuckets - 1 && (time >> (bucket + 1)) != 0)
+		bucket++;
+	entry.buckets[bucket]++;
+}
+
+// upper bound of histogram's bucket, which has p-th part of calls
+uint64_t IBridgeProfiler::Percentile(const Entry & entry, double p)
+{
+	int64_t rank = int64_t(entry.calls * p + 0.5);
+	if (rank < 1)
+		rank = 1;
+	int64_t count = 0;
+	for (int i = 0; i < kBuckets; i++) {
+		count += entry.buckets[i];
+		if (count >= rank)
+			return std::min(uint64_t(2) << i, entry.maxNs);
+	}
+	return entry.maxNs;
+}
+
+std::string IBridgeProfiler::ToJSON()
+{
+	std::ostringstream out;
+	out << '[';
+	bool first = true;
+	for (auto &item : entries) {
+		auto &key = item.first;
+		auto &entry = item.second;
+		IObjectTemplate * owner = nullptr;
+		std::string name;
+		if (key.member) {
+			if (key.kind == kMethod) {
+				auto method = static_cast<IObjectMethod *>(key.member);
+				owner = method->owner;
+				name = method->name;
+			}
+			else {
+				auto prop = static_cast<IObjectProp *>(key.member);
+				owner = prop->owner;
+				name = prop->name;
+			}
+		}
+		if (!first)
+			out << ',';
+		first = false;
+		out << "{\"class\":";
+		WriteJSONString(out, owner ? owner->classTypeName : std::string());
+		out << ",\"member\":";
+		WriteJSONString(out, name);
+		out << ",\"kind\":\"" << profileKindNames[key.kind] << '"'
+			<< ",\"calls\":" << entry.calls
+			<< ",\"totalNs\":" << entry.totalNs
+			<< ",\"hostNs\":" << entry.hostNs
+			<< ",\"bridgeNs\":" << entry.totalNs - entry.hostNs
+			<< ",\"maxNs\":" << entry.maxNs
+			<< ",\"p50Ns\":" << Percentile(entry, 0.5)
+			<< ",\"p90Ns\":" << Percentile(entry, 0.9)
+			<< ",\"p99Ns\":" << Percentile(entry, 0.99) << '}';
+	}
+	out << ']';
+	return out.str();
+}
+
 IObjectTemplate * IEngine::GetObjectByClass(void * dClass)
 {
 	// TODO: std::unordered_map
@@ -156,35 +531,50 @@ std::vector<char *> IEngine::MakeArgs(char * codeParam, bool isFileName, int& ar
 
 v8::Local<v8::FunctionTemplate> IEngine::AddV8ObjectTemplate(IObjectTemplate * obj)
 {
+	// parent can be created before its child, when child's template was made first
+	if (!obj->objTempl.IsEmpty())
+		return obj->objTempl;
 	obj->FieldCount = ObjectInternalFieldCount;
 	auto V8Object = v8::FunctionTemplate::New(isolate);
-    V8Object->SetClassName(v8::String::NewFromUtf8(isolate, obj->classTypeName.c_str(), v8::NewStringType::kNormal).ToLocalChecked());
+    V8Object->SetClassName(InternName(obj->classTypeName.c_str()));
+	// members are set to prototype, so instances of class (and its descendants) share them;
+	// inherited members are got from parent's prototype.
+	// Because of it they are not own props of wrapper: Object.keys(obj) and JSON.stringify(obj)
+	// don't list them and obj.hasOwnProperty(name) is false, use "name in obj" instead
+	if (obj->parent)
+		V8Object->Inherit(AddV8ObjectTemplate(obj->parent));
+	auto proto = V8Object->PrototypeTemplate();
+	auto signature = v8::Signature::New(isolate, V8Object);
+	auto accessorSignature = v8::AccessorSignature::New(isolate, V8Object);
 	for (auto &field : obj->fields) {
-		V8Object->InstanceTemplate()->SetAccessor(v8::String::NewFromUtf8(isolate, field.c_str(), v8::NewStringType::kNormal).ToLocalChecked(),
-			FieldGetter, FieldSetter);
+		proto->SetAccessor(InternName(field->name.c_str()),
+			FieldGetter, FieldSetter, v8::External::New(isolate, field.get()), v8::DEFAULT, v8::None, accessorSignature);
 	}
 	for (auto &prop : obj->props) {
-		V8Object->InstanceTemplate()->SetAccessor(v8::String::NewFromUtf8(isolate, prop->name.c_str(), v8::NewStringType::kNormal).ToLocalChecked(),
+		proto->SetAccessor(InternName(prop->name.c_str()),
 			prop->read? Getter : (v8::AccessorGetterCallback)0,
 			prop->write? Setter : (v8::AccessorSetterCallback)0, 
-			v8::External::New(isolate, prop->obj));
+			v8::External::New(isolate, prop.get()), v8::DEFAULT, v8::None, accessorSignature);
 	}
 
-	auto inc = 0;
 	for (auto &method : obj->methods) {
-		v8::Local<v8::FunctionTemplate> methodCallBack = v8::FunctionTemplate::New(isolate, FuncCallBack, v8::External::New(isolate, method->call));
-		V8Object->InstanceTemplate()->Set(v8::String::NewFromUtf8(isolate, method->name.c_str(), v8::NewStringType::kNormal).ToLocalChecked(), methodCallBack);
+		v8::Local<v8::FunctionTemplate> methodCallBack = v8::FunctionTemplate::New(isolate, FuncCallBack, v8::External::New(isolate, method.get()), signature);
+		proto->Set(InternName(method->name.c_str()), methodCallBack);
 	}
-    V8Object->InstanceTemplate()->Set(v8::String::NewFromUtf8(isolate, "toString", v8::NewStringType::kNormal).ToLocalChecked(), v8::FunctionTemplate::New(isolate, toStringCallBack));
+	if (!obj->parent)
+		proto->Set(InternName("toString"),
+			v8::FunctionTemplate::New(isolate, toStringCallBack, v8::Local<v8::Value>(), signature));
 
 	for (auto &prop : obj->ind_props) {
-		V8Object->InstanceTemplate()->SetAccessor(v8::String::NewFromUtf8(isolate, prop->name.c_str(), v8::NewStringType::kNormal).ToLocalChecked(),
+		proto->SetAccessor(InternName(prop->name.c_str()),
 			prop->read ? IndexedPropObjGetter : (v8::AccessorGetterCallback)0, (v8::AccessorSetterCallback)0,
-			v8::External::New(isolate, prop->obj));
+			v8::External::New(isolate, prop.get()), v8::DEFAULT, v8::None, accessorSignature);
 	}
 
 	if (obj->HasIndexedProps) {
 		V8Object->InstanceTemplate()->SetIndexedPropertyHandler(IndexedPropGetter, IndexedPropSetter);
+		// for cached ranges of default indexed property
+		obj->FieldCount = IndexedCacheIndex + 1;
 	}
 	V8Object->InstanceTemplate()->SetInternalFieldCount(obj->FieldCount);
 	obj->objTempl = V8Object;
@@ -218,12 +608,18 @@ static void log(const v8::FunctionCallbackInfo<v8::Value>& args) {
 }
 
 inline IValue * IEngine::RunString(char * code, char * scriptName, char * scriptPath, char * additionalParams) {
+	BumpScriptEpoch();
 	try {
 		errCode = -1;
-		int argc = 0;
-		auto argv = MakeArgs(code, false, argc, scriptName, additionalParams);
 		uv_chdir(scriptPath);
-		node_engine->RunScript(argc, argv.data(), [this](int code) {this->SetErrorCode(code); }, this);
+		if (!WarmRun() ||
+			node_engine->RunScriptWarm(scriptName, code, false, [this](int code) {this->SetErrorCode(code); }, this) < 0) {
+			int argc = 0;
+			auto argv = MakeArgs(code, false, argc, scriptName, additionalParams);
+			node_engine->RunScript(argc, argv.data(), [this](int code) {this->SetErrorCode(code); }, this);
+		}
+		if (node_engine->WasInterrupted())
+			errCode = kInterruptedErrCode;
 	}
 	catch (node::V8Exception &e) {
 		errCode = 1000;
@@ -238,14 +634,20 @@ inline IValue * IEngine::RunString(char * code, char * scriptName, char * script
 
 char * IEngine::RunFile(char * fName, char * exeName, char * additionalParams)
 {
+	BumpScriptEpoch();
 	try {
-		int argc = 0;
-		auto argv = MakeArgs(fName, true, argc, exeName, additionalParams);
         std::string filePath = fName;
         size_t pos = filePath.find_last_of("\\/");
         filePath = (std::string::npos == pos)? "" : filePath.substr(0, pos);
         uv_chdir(filePath.c_str());
-		node_engine->RunScript(argc, argv.data(), [this](int code) {this->SetErrorCode(code); }, this);
+		if (!WarmRun() ||
+			node_engine->RunScriptWarm(fName, nullptr, true, [this](int code) {this->SetErrorCode(code); }, this) < 0) {
+			int argc = 0;
+			auto argv = MakeArgs(fName, true, argc, exeName, additionalParams);
+			node_engine->RunScript(argc, argv.data(), [this](int code) {this->SetErrorCode(code); }, this);
+		}
+		if (node_engine->WasInterrupted())
+			errCode = kInterruptedErrCode;
 	}
 	catch (node::V8Exception &e) {
 		errCode = 1000;
@@ -258,22 +660,21 @@ char * IEngine::RunFile(char * fName, char * exeName, char * additionalParams)
 
 char * IEngine::RunIncludeFile(char * fName)
 {
-	v8::Local<v8::String> source;
+	BumpScriptEpoch();
+	std::string buf_str;
 	{
-		std::ifstream t(fName);
-		std::stringstream buffer;
-		buffer << t.rdbuf();
-		auto buf_str = buffer.str();
-		auto source_str = buf_str.data();
-		source = v8::String::NewFromUtf8(isolate, source_str, v8::NewStringType::kNormal).ToLocalChecked();
+		std::ifstream t(fName, std::ios::binary);
+		buf_str.assign(std::istreambuf_iterator<char>(t), std::istreambuf_iterator<char>());
 	}
+	v8::Local<v8::String> source = v8::String::NewFromUtf8(isolate, buf_str.data(), v8::NewStringType::kNormal,
+		int(buf_str.size())).ToLocalChecked();
 
 	v8::ScriptOrigin origin(v8::String::NewFromUtf8(isolate, fName, v8::NewStringType::kNormal).ToLocalChecked());
 	auto context = isolate->GetCurrentContext();
 	//for debug>>>>>>>>>
 	//<<<<<<<<<for debug
 	v8::Local<v8::Script> script;
-	if (v8::Script::Compile(context, source, &origin).ToLocal(&script)) {
+	if (codeCache.Compile(context, source, &origin, buf_str.data(), buf_str.size()).ToLocal(&script)) {
 		script->Run(context);
 	}
 
@@ -285,6 +686,7 @@ char * IEngine::RunIncludeFile(char * fName)
 
 char * IEngine::RunIncludeCode(char * code)
 {
+	BumpScriptEpoch();
 	v8::Local<v8::String> source = v8::String::NewFromUtf8(isolate, code, v8::NewStringType::kNormal).ToLocalChecked();
 
 	v8::ScriptOrigin origin(source);
@@ -292,7 +694,7 @@ char * IEngine::RunIncludeCode(char * code)
 	//for debug>>>>>>>>>
 	//<<<<<<<<<for debug
 	v8::Local<v8::Script> script;
-	if (v8::Script::Compile(context, source, &origin).ToLocal(&script)) {
+	if (codeCache.Compile(context, source, &origin, code, strlen(code)).ToLocal(&script)) {
 		script->Run(context);
 	}
 
@@ -310,24 +712,25 @@ void IEngine::AddIncludeCode(char * code)
 
 IValue * IEngine::CallFunc(char * funcName, IValueArray * args)
 {
+	BumpScriptEpoch();
 	v8::Isolate::Scope scope(isolate);
+	v8::Locker locker(isolate);
+	//handles of the call mustn't outlive it, result is kept by KeepValue
+	v8::HandleScope handle_scope(isolate);
 	auto context = isolate->GetCurrentContext();
 	auto glo = context->Global();
-	v8::Locker locker(isolate);
-	auto maybe_val = glo->Get(context, v8::String::NewFromUtf8(isolate, funcName, v8::NewStringType::kNormal).ToLocalChecked());
+	auto maybe_val = glo->Get(context, InternName(funcName));
 	if (!maybe_val.IsEmpty()) {
 		auto val = maybe_val.ToLocalChecked();
 		if (val->IsFunction()) {
 			try {
 				auto func = val.As<v8::Function>();
-				std::vector<v8::Local<v8::Value>> argv = args->GeV8ValueVector();
+				std::vector<v8::Local<v8::Value>> argv;
+				if (args)
+					argv = args->GeV8ValueVector();
 				auto func_result = func->Call(context, glo, argv.size(), argv.data());
-				if (!func_result.IsEmpty()) {
-					auto result_value = std::make_unique<IValue>(isolate, func_result.ToLocalChecked(), -1);
-					auto result = result_value.get();
-					IValues.push_back(std::move(result_value));
-					return result;
-				}
+				if (!func_result.IsEmpty())
+					return KeepValue(func_result.ToLocalChecked());
 			}
 			catch (node::V8Exception &e) {
 				return nullptr;
@@ -338,6 +741,21 @@ IValue * IEngine::CallFunc(char * funcName, IValueArray * args)
 	return nullptr;
 }
 
+IPreparedCall * IEngine::PrepareCall(char * funcName)
+{
+	v8::Isolate::Scope scope(isolate);
+	v8::Locker locker(isolate);
+	v8::HandleScope handle_scope(isolate);
+	auto context = isolate->GetCurrentContext();
+	auto maybe_val = context->Global()->Get(context, InternName(funcName));
+	if (maybe_val.IsEmpty() || !maybe_val.ToLocalChecked()->IsFunction())
+		return nullptr;
+	auto call = std::make_unique<IPreparedCall>(isolate, maybe_val.ToLocalChecked().As<v8::Function>());
+	auto result = call.get();
+	preparedCalls.push_back(std::move(call));
+	return result;
+}
+
 void IEngine::SetInactive()
 {
     isolate->SetData(EngineSlot, nullptr);
@@ -354,6 +772,12 @@ bool IEngine::DebugMode()
 	return debugMode;
 }
 
+bool IEngine::WarmRun()
+{
+	//debug agent is started only by bootstrap
+	return warmRun && !debugMode;
+}
+
 int IEngine::ErrorCode()
 {
 	return errCode;
@@ -371,11 +795,33 @@ void IEngine::ExecIncludeCode(v8::Local<v8::Context> context)
 	v8::ScriptOrigin origin(v8::String::NewFromUtf8(isolate, "", v8::NewStringType::kNormal).ToLocalChecked());
 	//auto context = isolate->GetCurrentContext();
 	v8::Local<v8::Script> script;
-	if (v8::Script::Compile(context, source, &origin).ToLocal(&script)) {
+	if (codeCache.Compile(context, source, &origin, include_code.data(), include_code.size()).ToLocal(&script)) {
 		script->Run(context);
 	}
 }
 
+void IEngine::SetupProcessObject(v8::Local<v8::Object> process)
+{
+	auto iso = process->GetIsolate();
+	auto setDir = [iso, process](const char * name, const std::string & dir) {
+		process->Set(iso->GetCurrentContext(),
+			v8::String::NewFromUtf8(iso, name, v8::NewStringType::kNormal).ToLocalChecked(),
+			v8::String::NewFromUtf8(iso, dir.c_str(), v8::NewStringType::kNormal).ToLocalChecked()).FromJust();
+	};
+	//modules are compiled with code cache by lib/internal/code_cache.js
+	if (codeCache.Enabled())
+		setDir("_codeCacheDir", codeCache.Dir());
+	//used by lib/internal/ts_cache.js
+	if (!transpileCacheDir.empty())
+		setDir("_tsCacheDir", transpileCacheDir);
+	//used by lib/internal/ts_prefetch.js; zero threads there mean count of processors
+	if (transpileThreads != 0) {
+		process->Set(iso->GetCurrentContext(),
+			v8::String::NewFromUtf8(iso, "_tsPrefetchThreads", v8::NewStringType::kNormal).ToLocalChecked(),
+			v8::Integer::New(iso, transpileThreads < 0 ? 0 : transpileThreads)).FromJust();
+	}
+}
+
 inline void IEngine::SetMethodCallBack(TMethodCallBack callBack) {
 	methodCall = callBack;
 }
@@ -417,6 +863,11 @@ void IEngine::SetIndexedPropSetterNumberCallBack(TSetterCallBack callBack)
 	IndPropSetterCall = callBack;
 }
 
+void IEngine::SetIndexedPropRangeCallBack(TGetterCallBack callBack)
+{
+	IndPropRangeCall = callBack;
+}
+
 void IEngine::SetNamedPropGetterNumberCallBack(TGetterCallBack callBack)
 {
     NamedPropGetterCall = callBack;
@@ -456,10 +907,8 @@ IValueArray * IEngine::NewArray(int count)
 {
 	if (isolate) {
 		v8::Isolate::Scope scope(isolate);
-		run_result_array = std::make_unique<IValueArray>(isolate, count);
-		auto new_array = run_result_array.get();
-		IValues.push_back(std::move(run_result_array));
-		return new_array;
+		v8::HandleScope handle_scope(isolate);
+		return Keep(std::make_unique<IValueArray>(isolate, count));
 	}
 	return nullptr;
 }
@@ -468,10 +917,8 @@ IValue * IEngine::NewInteger(int value)
 {
 	if (isolate) {
 		v8::Isolate::Scope scope(isolate);
-		run_result_value = std::make_unique<IValue>(isolate, v8::Integer::New(isolate, value), -1);
-		auto result = run_result_value.get();
-		IValues.push_back(std::move(run_result_value));
-		return result;
+		v8::HandleScope handle_scope(isolate);
+		return KeepValue(v8::Integer::New(isolate, value));
 	}
 	return nullptr;
 }
@@ -480,10 +927,8 @@ IValue * IEngine::NewNumber(double value)
 {
 	if (isolate) {
 		v8::Isolate::Scope scope(isolate);
-		run_result_value = std::make_unique<IValue>(isolate, v8::Number::New(isolate, value), -1);
-		auto result = run_result_value.get();
-		IValues.push_back(std::move(run_result_value));
-		return result;
+		v8::HandleScope handle_scope(isolate);
+		return KeepValue(v8::Number::New(isolate, value));
 	}
 	return nullptr;
 }
@@ -492,38 +937,59 @@ IValue * IEngine::NewString(char * value)
 {
 	if (isolate) {
 		v8::Isolate::Scope scope(isolate);
-		run_result_value = std::make_unique<IValue>(isolate, v8::String::NewFromUtf8(isolate, value, v8::NewStringType::kNormal).ToLocalChecked(), -1);
-		auto result = run_result_value.get();
-		IValues.push_back(std::move(run_result_value));
-		return result;
+		v8::HandleScope handle_scope(isolate);
+		return KeepValue(v8::String::NewFromUtf8(isolate, value, v8::NewStringType::kNormal).ToLocalChecked());
+	}
+	return nullptr;
+}
+
+IValue * IEngine::NewUnicodeString(uint16_t * value, int len)
+{
+	if (isolate) {
+		v8::Isolate::Scope scope(isolate);
+		v8::HandleScope handle_scope(isolate);
+		return KeepValue(Bv8::NewUnicodeString(isolate, value, len));
 	}
 	return nullptr;
 }
 
+void IEngine::SetProfiling(bool enabled)
+{
+	profiler.enabled = enabled;
+}
+
+char * IEngine::ProfileJSON()
+{
+	profileJSON = profiler.ToJSON();
+	return const_cast<char *>(profileJSON.c_str());
+}
+
+void IEngine::ResetProfile()
+{
+	profiler.Reset();
+}
+
 IValue * IEngine::NewBool(bool value)
 {
 	if (isolate) {
 		v8::Isolate::Scope scope(isolate);
-		run_result_value = std::make_unique<IValue>(isolate, v8::Boolean::New(isolate, value), -1);
-		auto result = run_result_value.get();
-		IValues.push_back(std::move(run_result_value));
-		return result;
+		v8::HandleScope handle_scope(isolate);
+		return KeepValue(v8::Boolean::New(isolate, value));
 	}
 	return nullptr;
 }
 
 IRecord * IEngine::NewRecord()
 {
-    std::unique_ptr<IRecord> res_value = std::make_unique<IRecord>(isolate);
-    auto result = res_value.get();
-    IValues.push_back(std::move(res_value));
-    return result;
+    v8::HandleScope handle_scope(isolate);
+    return Keep(std::make_unique<IRecord>(isolate));
 }
 
 IObject * IEngine::NewObject(void * value, void * classtype)
 {
     if (isolate) {
         v8::Isolate::Scope scope(isolate);
+        v8::HandleScope handle_scope(isolate);
         IEngine * eng = IEngine::GetEngine(isolate);
         IObject * result = nullptr;
 		if (!eng->ClassIsRegistered(classtype)) {
@@ -541,11 +1007,8 @@ IObject * IEngine::NewObject(void * value, void * classtype)
                 AddObject(value, classtype, obj, isolate);
             }
         }
-        if (!obj.IsEmpty()) {
-            run_result_object = std::make_unique<IObject>(isolate, obj);
-            result = run_result_object.get();
-            IValues.push_back(std::move(run_result_value));
-        }
+        if (!obj.IsEmpty())
+            result = Keep(std::make_unique<IObject>(isolate, obj));
         return result;
     }
 	return nullptr;
@@ -554,13 +1017,11 @@ IObject * IEngine::NewObject(void * value, void * classtype)
 IValue * IEngine::NewInterfaceObject(void * value)
 {
     if (isolate) {
+        v8::HandleScope handle_scope(isolate);
         auto ctx = isolate->GetCurrentContext();
         v8::Local<v8::Object> obj = ifaceTemplate->NewInstance(ctx).ToLocalChecked();
         obj->SetInternalField(DelphiObjectIndex, v8::External::New(isolate, value));
-        run_result_value = std::make_unique<IValue>(isolate, obj, -1);
-        auto result = run_result_value.get();
-        IValues.push_back(std::move(run_result_value));
-        return result;
+        return KeepValue(obj);
     }
     return nullptr;
 }
@@ -611,21 +1072,94 @@ void * IEngine::GetRegisteredParentClasstype(void * classtype)
 
 v8::Local<v8::Object> IEngine::FindObject(void * dObj, void * classType, v8::Isolate * iso)
 {
-	uint64_t hash = (uint64_t(dObj) << 32) + uint32_t(classType);
-	auto result = JSObjects.find(hash);
-	if (result != JSObjects.end())
+	auto result = JSObjects.find(WrapperKey{ dObj, classType });
+	if (result != JSObjects.end() && !result->second->handle.IsEmpty())
 	{
-		return result->second.Get(iso);
+		wrapperHits++;
+		return result->second->handle.Get(iso);
 	}
-	else
-		return v8::Local<v8::Object>();
+	wrapperMisses++;
+	return v8::Local<v8::Object>();
 }
 
 void IEngine::AddObject(void * dObj, void * classType, v8::Local<v8::Object> obj, v8::Isolate * iso)
 {
-	uint64_t hash = (uint64_t(dObj) << 32) + uint32_t(classType);
-	v8::Persistent<v8::Object, v8::CopyablePersistentTraits<v8::Object>> persistent_obj(iso, obj);
-	JSObjects.emplace(std::make_pair(hash, persistent_obj));
+	auto entry = std::make_unique<WrapperCacheEntry>();
+	entry->key = WrapperKey{ dObj, classType };
+	entry->engine = this;
+	entry->handle.Reset(iso, obj);
+	entry->handle.SetWeak(entry.get(), WrapperCollected, v8::WeakCallbackType::kParameter);
+	// replaces (and resets) wrapper, that could be left for the same key
+	JSObjects[entry->key] = std::move(entry);
+}
+
+void IEngine::WrapperCollected(const v8::WeakCallbackInfo<WrapperCacheEntry>& info)
+{
+	WrapperCacheEntry * entry = info.GetParameter();
+	IEngine * engine = entry->engine;
+	WrapperKey key = entry->key;
+	// replaced entries are reset on replacing, so only actual entry can get here
+	engine->JSObjects.erase(key);
+	engine->wrapperEvictions++;
+	if (engine->ObjectCollectedCallBack)
+		engine->ObjectCollectedCallBack(key.dObj, key.classType, engine->DEngine);
+}
+
+v8::Local<v8::ArrayBuffer> IEngine::NewArrayBuffer(void * data, size_t byteLength, bool copy)
+{
+	if (!copy)
+		return v8::ArrayBuffer::New(isolate, data, byteLength, v8::ArrayBufferCreationMode::kExternalized);
+	auto buffer = v8::ArrayBuffer::New(isolate, byteLength);
+	if (byteLength > 0)
+		memcpy(buffer->GetContents().Data(), data, byteLength);
+	return buffer;
+}
+
+IValue * IEngine::NewFloat64Array(void * data, size_t len, bool copy)
+{
+	if (isolate) {
+		v8::Isolate::Scope scope(isolate);
+		v8::HandleScope handle_scope(isolate);
+		auto buffer = NewArrayBuffer(data, len * sizeof(double), copy);
+		return KeepValue(v8::Float64Array::New(buffer, 0, len));
+	}
+	return nullptr;
+}
+
+IValue * IEngine::NewInt32Array(void * data, size_t len, bool copy)
+{
+	if (isolate) {
+		v8::Isolate::Scope scope(isolate);
+		v8::HandleScope handle_scope(isolate);
+		auto buffer = NewArrayBuffer(data, len * sizeof(int32_t), copy);
+		return KeepValue(v8::Int32Array::New(buffer, 0, len));
+	}
+	return nullptr;
+}
+
+void IEngine::SetObjectCollectedCallBack(TObjectCollectedCallBack callBack)
+{
+	ObjectCollectedCallBack = callBack;
+}
+
+int IEngine::WrapperCacheSize()
+{
+	return int(JSObjects.size());
+}
+
+int64_t IEngine::WrapperCacheHits()
+{
+	return wrapperHits;
+}
+
+int64_t IEngine::WrapperCacheMisses()
+{
+	return wrapperMisses;
+}
+
+int64_t IEngine::WrapperCacheEvictions()
+{
+	return wrapperEvictions;
 }
 
 void IEngine::LogErrorMessage(const char * msg)
@@ -635,6 +1169,214 @@ void IEngine::LogErrorMessage(const char * msg)
 	}
 }
 
+IValue * IEngine::KeepValue(v8::Local<v8::Value> value)
+{
+	if (freeValues.empty())
+		return Keep(std::make_unique<IValue>(isolate, value, -1));
+	// released IValue objects are reused instead of allocating new ones
+	auto kept_value = std::move(freeValues.back());
+	freeValues.pop_back();
+	kept_value->Reset(v8::Local<v8::Value>(), -1);
+	kept_value->SetV8Value(value);
+	return Keep(std::move(kept_value));
+}
+
+IValue * IEngine::KeepDetachedValue(v8::Local<v8::Value> value)
+{
+	detachedValues.push_back(std::make_unique<IValue>(isolate, value, -1));
+	return detachedValues.back().get();
+}
+
+void IEngine::KeepUnicodeConversion(v8::Local<v8::Value> val, v8::Local<v8::String> str)
+{
+	unicodeSource.Reset(isolate, val);
+	unicodeString.Reset(isolate, str);
+	unicodeEpoch = scriptEpoch;
+}
+
+bool IEngine::TakeUnicodeConversion(v8::Local<v8::Value> val, v8::Local<v8::String> * str)
+{
+	if (unicodeSource.IsEmpty())
+		return false;
+	bool found = unicodeEpoch == scriptEpoch && v8::Local<v8::Value>::New(isolate, unicodeSource) == val;
+	if (found)
+		*str = v8::Local<v8::String>::New(isolate, unicodeString);
+	unicodeSource.Reset();
+	unicodeString.Reset();
+	return found;
+}
+
+void IEngine::BeginValueScope()
+{
+	valueScopes.push_back(IValues.size());
+}
+
+void IEngine::EndValueScope()
+{
+	if (valueScopes.empty())
+		return;
+	size_t mark = valueScopes.back();
+	valueScopes.pop_back();
+	for (size_t i = mark; i < IValues.size(); i++) {
+		auto value = IValues[i].pooled;
+		if (value && freeValues.size() < MaxFreeValues) {
+			// releases persistent handle, object itself goes to the pool
+			value->Reset(v8::Local<v8::Value>(), -1);
+			IValues[i].value.release();
+			freeValues.push_back(std::unique_ptr<IValue>(value));
+		}
+	}
+	IValues.resize(mark);
+}
+
+int IEngine::ValueCount()
+{
+	return int(IValues.size());
+}
+
+void IEngine::SetWarmRun(bool warm)
+{
+	warmRun = warm;
+}
+
+void IEngine::SetCodeCacheDir(char * dir)
+{
+	codeCache.SetDir(dir);
+}
+
+void IEngine::SetTranspileCacheDir(char * dir)
+{
+	transpileCacheDir = dir ? dir : "";
+}
+
+void IEngine::SetTranspileThreads(int threads)
+{
+	transpileThreads = threads;
+}
+
+void IEngine::SetStepMode(bool step)
+{
+	node_engine->SetStepMode(step);
+}
+
+int IEngine::RunFor(int ms)
+{
+	BumpScriptEpoch();
+	try {
+		int res = node_engine->RunFor(ms > 0 ? unsigned(ms) : 0);
+		if (node_engine->WasInterrupted())
+			errCode = kInterruptedErrCode;
+		return res;
+	}
+	catch (node::V8Exception &e) {
+		errCode = 1000;
+		return 0;
+	}
+}
+
+int IEngine::PumpOnce()
+{
+	BumpScriptEpoch();
+	try {
+		int res = node_engine->PumpOnce();
+		if (node_engine->WasInterrupted())
+			errCode = kInterruptedErrCode;
+		return res;
+	}
+	catch (node::V8Exception &e) {
+		errCode = 1000;
+		return 0;
+	}
+}
+
+void IEngine::SetRunLimits(int wallMs, int cpuMs)
+{
+	node_engine->SetRunLimits(wallMs > 0 ? unsigned(wallMs) : 0, cpuMs > 0 ? unsigned(cpuMs) : 0);
+}
+
+void IEngine::Interrupt()
+{
+	node_engine->Interrupt();
+}
+
+void IEngine::GetHeapStatistics(HeapStats * stats)
+{
+	v8::HeapStatistics heap;
+	node_engine->node_engine_isolate->GetHeapStatistics(&heap);
+	stats->totalHeapSize = heap.total_heap_size();
+	stats->totalHeapSizeExecutable = heap.total_heap_size_executable();
+	stats->totalPhysicalSize = heap.total_physical_size();
+	stats->totalAvailableSize = heap.total_available_size();
+	stats->usedHeapSize = heap.used_heap_size();
+	stats->heapSizeLimit = heap.heap_size_limit();
+}
+
+void IEngine::LowMemoryNotification()
+{
+	node_engine->node_engine_isolate->LowMemoryNotification();
+}
+
+void IEngine::HeapLimitCheck(v8::Isolate * iso, v8::GCType type, v8::GCCallbackFlags flags)
+{
+	IEngine * engine = GetEngine(iso);
+	if (!engine)
+		return;
+	v8::HeapStatistics heap;
+	iso->GetHeapStatistics(&heap);
+	double used = double(heap.used_heap_size()) / heap.heap_size_limit();
+	if (engine->nearHeapLimit) {
+		if (used < kHeapLimitReset)
+			engine->nearHeapLimit = false;
+		return;
+	}
+	if (used < kNearHeapLimit)
+		return;
+	engine->nearHeapLimit = true;
+	std::string msg = "heap is near its limit: " + std::to_string(heap.used_heap_size() >> 20) +
+		" MB of " + std::to_string(heap.heap_size_limit() >> 20) + " MB are used";
+	if (engine->heapLimitsSet) {
+		msg += ", script is interrupted";
+		engine->node_engine->Interrupt();
+	}
+	engine->LogErrorMessage(msg.c_str());
+}
+
+int64_t IEngine::ModuleCodeCacheStat(const char * name)
+{
+	if (!isolate)
+		return 0;
+	v8::HandleScope scope(isolate);
+	auto context = isolate->GetCurrentContext();
+	if (context.IsEmpty())
+		return 0;
+	auto key = [this](const char * str) {
+		return v8::String::NewFromUtf8(isolate, str, v8::NewStringType::kNormal).ToLocalChecked();
+	};
+	v8::Local<v8::Value> process, stats, value;
+	if (!context->Global()->Get(context, key("process")).ToLocal(&process) || !process->IsObject())
+		return 0;
+	if (!process.As<v8::Object>()->Get(context, key("_codeCacheStats")).ToLocal(&stats) || !stats->IsObject())
+		return 0;
+	if (!stats.As<v8::Object>()->Get(context, key(name)).ToLocal(&value) || !value->IsNumber())
+		return 0;
+	return int64_t(value.As<v8::Number>()->Value());
+}
+
+int64_t IEngine::CodeCacheHits()
+{
+	return codeCache.hits + ModuleCodeCacheStat("hits");
+}
+
+int64_t IEngine::CodeCacheMisses()
+{
+	return codeCache.misses + ModuleCodeCacheStat("misses");
+}
+
+int64_t IEngine::CodeCacheRejects()
+{
+	return codeCache.rejects + ModuleCodeCacheStat("rejects");
+}
+
 v8::Local<v8::ObjectTemplate> IEngine::MakeGlobalTemplate(v8::Isolate * iso)
 {
 	//isolate should be already entered;
@@ -648,24 +1390,31 @@ v8::Local<v8::ObjectTemplate> IEngine::MakeGlobalTemplate(v8::Isolate * iso)
 	ifaceTemplate->SetHandler(conf);
 	////making indexed object template
 	indexedObjTemplate = v8::ObjectTemplate::New(iso);
-	indexedObjTemplate->SetInternalFieldCount(ObjectInternalFieldCount);
+	indexedObjTemplate->SetInternalFieldCount(ObjectInternalFieldCount + 1);
+	// for..of goes by length and indexes, so it uses cached ranges too
+	indexedObjTemplate->SetIntrinsicDataProperty(v8::Symbol::GetIterator(iso), v8::kArrayProto_values);
 	indexedObjTemplate->SetIndexedPropertyHandler(IndexedPropGetter, IndexedPropSetter);
     indexedObjTemplate->SetNamedPropertyHandler(NamedPropGetter, NamedPropSetter);
 
+	// templates of previous run are not valid anymore
+	for (auto &obj : objects) {
+		obj->objTempl.Clear();
+	}
 	v8::Local<v8::FunctionTemplate> global = v8::FunctionTemplate::New(isolate);
 	if (globalTemplate) {
 		for (auto &method : globalTemplate->methods) {
-			v8::Local<v8::FunctionTemplate> methodCallBack = v8::FunctionTemplate::New(isolate, FuncCallBack, v8::External::New(isolate, method->call));
+			v8::Local<v8::FunctionTemplate> methodCallBack = v8::FunctionTemplate::New(isolate, FuncCallBack, v8::External::New(isolate, method.get()));
 			global->PrototypeTemplate()->Set(
-				v8::String::NewFromUtf8(isolate, method->name.c_str(), v8::NewStringType::kNormal).ToLocalChecked(),
+				InternName(method->name.c_str()),
 				methodCallBack);
 		}
 
 		for (auto &prop : globalTemplate->props) {
 			auto prop_name = prop->name.c_str();
-			global->PrototypeTemplate()->SetAccessor(v8::String::NewFromUtf8(isolate, prop_name, v8::NewStringType::kNormal).ToLocalChecked(), 
+			global->PrototypeTemplate()->SetAccessor(InternName(prop_name), 
 				Getter, 
-				prop->write ? Setter : (v8::AccessorSetterCallback)0);
+				prop->write ? Setter : (v8::AccessorSetterCallback)0,
+				v8::External::New(isolate, prop.get()));
 		}
 		for (auto &enumField : globalTemplate->enums) {
 			global->PrototypeTemplate()->Set(isolate, enumField->name.c_str(), v8::Integer::New(isolate, enumField->value));
@@ -680,23 +1429,156 @@ v8::Local<v8::ObjectTemplate> IEngine::MakeGlobalTemplate(v8::Isolate * iso)
 	return global->PrototypeTemplate();
 }
 
-IEngine::IEngine(void * DEngine)
+IEngine::IEngine(void * DEngine, const char * snapshot, int snapshotSize,
+	int maxOldSpaceMb, int maxSemiSpaceMb)
 {
 	this->DEngine = DEngine;
 	ErrMsgCallBack = nullptr;
 	include_code = "";
-	node_engine = new node::NodeEngine();
+	node_engine = new node::NodeEngine(snapshot, snapshotSize, maxOldSpaceMb, maxSemiSpaceMb);
+	heapLimitsSet = maxOldSpaceMb > 0 || maxSemiSpaceMb > 0;
+	node_engine->node_engine_isolate->AddGCEpilogueCallback(HeapLimitCheck);
 }
 
 IEngine::~IEngine()
 {
 	if (isolate)
 		isolate->SetData(EngineSlot, nullptr);
+	preparedCalls.clear();
+	recordShapes.clear();
 	node_engine->StopScript();
 	JSObjects.clear();
+	IValues.clear();
+	freeValues.clear();
+	detachedValues.clear();
+	unicodeSource.Reset();
+	unicodeString.Reset();
 	delete node_engine;
 }
 
+static uint32_t RangeCount(v8::Local<v8::Value> values)
+{
+	if (values->IsArray())
+		return values.As<v8::Array>()->Length();
+	if (values->IsTypedArray())
+		return uint32_t(values.As<v8::TypedArray>()->Length());
+	return 0;
+}
+
+// current cache of holder, which has element index (any current one for index -1); range is asked
+// from host, if there is no such cache. Empty result means, that element is got by host's getter
+v8::Local<v8::Array> IEngine::IndexedRange(const v8::PropertyCallbackInfo<v8::Value>& info, int64_t index)
+{
+	auto holder = info.Holder();
+	if (!IndPropRangeCall || holder->InternalFieldCount() <= IndexedCacheIndex)
+		return v8::Local<v8::Array>();
+	auto ctx = isolate->GetCurrentContext();
+	uint32_t first = index < 0 ? 0 : uint32_t(index);
+	uint32_t start = first;
+	uint32_t size = kIndexedRangeMin;
+	auto field = holder->GetInternalField(IndexedCacheIndex);
+	if (field->IsArray()) {
+		auto cache = field.As<v8::Array>();
+		auto values = cache->Get(ctx, 3).ToLocalChecked();
+		// host declined ranges of this property, so it isn't asked again
+		if (!values->IsArray() && !values->IsTypedArray())
+			return v8::Local<v8::Array>();
+		uint32_t cacheStart = cache->Get(ctx, 1).ToLocalChecked()->Uint32Value(ctx).FromJust();
+		uint32_t cacheEnd = cacheStart + RangeCount(values);
+		uint32_t cacheSize = cache->Get(ctx, 4).ToLocalChecked()->Uint32Value(ctx).FromJust();
+		if (cache->Get(ctx, 0).ToLocalChecked()->NumberValue(ctx).FromJust() == scriptEpoch) {
+			int length = cache->Get(ctx, 2).ToLocalChecked()->Int32Value(ctx).FromJust();
+			if (index < 0 || (first >= cacheStart && first < cacheEnd) || (length >= 0 && first >= uint32_t(length)))
+				return cache;
+			// loop has passed cached range, so next one is bigger
+			size = first == cacheEnd ? std::min(cacheSize * 2, kIndexedRangeMax) : cacheSize;
+		}
+		// cache is made stale by host's calls, e.g. in loop, which calls element's methods,
+		// so next range is smaller
+		else
+			size = std::max(cacheSize / 2, 1u);
+		if (first < cacheStart)
+			start = first + 1 > size ? first + 1 - size : 0;
+	}
+	IBridgeProfiler::Scope profile(profiler, IBridgeProfiler::kIndexedRange, v8::Local<v8::Value>());
+	ArgsPool<IGetterArgs>::Scope rangeArgs(getterArgsPool, info, int(start), int(size));
+	profile.HostCall();
+	IndPropRangeCall(rangeArgs.get());
+	profile.HostDone();
+	if (rangeArgs->error != "")
+		return v8::Local<v8::Array>();
+	v8::Local<v8::Value> values = v8::Undefined(isolate);
+	if (!rangeArgs->rangeValues.IsEmpty())
+		values = rangeArgs->rangeValues;
+	auto cache = v8::Array::New(isolate, 5);
+	cache->Set(ctx, 0, v8::Number::New(isolate, scriptEpoch)).FromJust();
+	cache->Set(ctx, 1, v8::Integer::NewFromUnsigned(isolate, start)).FromJust();
+	cache->Set(ctx, 2, v8::Integer::New(isolate, rangeArgs->rangeLength)).FromJust();
+	cache->Set(ctx, 3, values).FromJust();
+	cache->Set(ctx, 4, v8::Integer::NewFromUnsigned(isolate, size)).FromJust();
+	holder->SetInternalField(IndexedCacheIndex, cache);
+	if (values->IsUndefined())
+		return v8::Local<v8::Array>();
+	uint32_t end = start + RangeCount(values);
+	int length = rangeArgs->rangeLength;
+	if (index < 0 || (first >= start && first < end) || (length >= 0 && first >= uint32_t(length)))
+		return cache;
+	return v8::Local<v8::Array>();
+}
+
+bool IEngine::IndexedCacheGet(const v8::PropertyCallbackInfo<v8::Value>& info, uint32_t index, v8::Local<v8::Value> & value)
+{
+	auto cache = IndexedRange(info, index);
+	if (cache.IsEmpty())
+		return false;
+	auto ctx = isolate->GetCurrentContext();
+	uint32_t start = cache->Get(ctx, 1).ToLocalChecked()->Uint32Value(ctx).FromJust();
+	auto values = cache->Get(ctx, 3).ToLocalChecked().As<v8::Object>();
+	// element is beyond list's length
+	if (index < start || index - start >= RangeCount(values)) {
+		value = v8::Undefined(isolate);
+		return true;
+	}
+	// element, set by script, is got by host's getter
+	if (values->IsArray() && !values->HasRealIndexedProperty(ctx, index - start).FromMaybe(false))
+		return false;
+	return values->Get(ctx, index - start).ToLocal(&value);
+}
+
+bool IEngine::IndexedCacheLength(const v8::PropertyCallbackInfo<v8::Value>& info, int & length)
+{
+	auto cache = IndexedRange(info, -1);
+	if (cache.IsEmpty())
+		return false;
+	auto ctx = isolate->GetCurrentContext();
+	length = cache->Get(ctx, 2).ToLocalChecked()->Int32Value(ctx).FromJust();
+	return length >= 0;
+}
+
+// after script's setter of element, cache of its own list stays valid (if nothing else was called
+// by host meanwhile), only the element is removed from it
+void IEngine::IndexedCacheSet(const v8::PropertyCallbackInfo<v8::Value>& info, uint32_t index, double epoch)
+{
+	auto holder = info.Holder();
+	if (scriptEpoch != epoch + 1 || holder->InternalFieldCount() <= IndexedCacheIndex)
+		return;
+	auto field = holder->GetInternalField(IndexedCacheIndex);
+	if (!field->IsArray())
+		return;
+	auto ctx = isolate->GetCurrentContext();
+	auto cache = field.As<v8::Array>();
+	if (cache->Get(ctx, 0).ToLocalChecked()->NumberValue(ctx).FromJust() != epoch)
+		return;
+	auto values = cache->Get(ctx, 3).ToLocalChecked();
+	// typed array can't have holes
+	if (values->IsTypedArray())
+		return;
+	uint32_t start = cache->Get(ctx, 1).ToLocalChecked()->Uint32Value(ctx).FromJust();
+	if (values->IsArray() && index >= start && index - start < RangeCount(values))
+		values.As<v8::Array>()->Delete(ctx, index - start).FromJust();
+	cache->Set(ctx, 0, v8::Number::New(isolate, scriptEpoch)).FromJust();
+}
+
 void IEngine::IndexedPropObjGetter(v8::Local<v8::String> property,
 	const v8::PropertyCallbackInfo<v8::Value>& info)
 {
@@ -704,10 +1586,12 @@ void IEngine::IndexedPropObjGetter(v8::Local<v8::String> property,
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kIndexedPropObj, info.Data());
 	if (engine->IndPropGetterObjCall) {
-		v8::String::Utf8Value str(property);
-		auto getterArgs = new IGetterArgs(info, *str);
-		engine->IndPropGetterObjCall(getterArgs);
+		ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, property.As<v8::Name>());
+		profile.HostCall();
+		engine->IndPropGetterObjCall(getterArgs.get());
+		profile.HostDone();
 		if (getterArgs->error != "")
 			engine->Throw_Exception(getterArgs->error.c_str());
 	}
@@ -719,9 +1603,17 @@ void IEngine::IndexedPropGetter(unsigned int index, const v8::PropertyCallbackIn
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	v8::Local<v8::Value> cached;
+	if (engine->IndexedCacheGet(info, index, cached)) {
+		info.GetReturnValue().Set(cached);
+		return;
+	}
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kIndexedGetter, v8::Local<v8::Value>());
 	if (engine->IndPropGetterCall) {
-		auto getterArgs = new IGetterArgs(info, index);
-		engine->IndPropGetterCall(getterArgs);
+		ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, index);
+		profile.HostCall();
+		engine->IndPropGetterCall(getterArgs.get());
+		profile.HostDone();
 		if (getterArgs->error != "")
 			engine->Throw_Exception(getterArgs->error.c_str());
 	}
@@ -733,9 +1625,17 @@ void IEngine::NamedPropGetter(v8::Local<v8::String> property, const v8::Property
     if (!engine)
         return;
     v8::Isolate::Scope iso_scope(engine->isolate);
+    int length;
+    if (property->StrictEquals(engine->InternName("length")) && engine->IndexedCacheLength(info, length)) {
+        info.GetReturnValue().Set(length);
+        return;
+    }
+    IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kNamedGetter, v8::Local<v8::Value>());
     if (engine->NamedPropGetterCall) {
-        auto getterArgs = new IGetterArgs(info, property);
-        engine->NamedPropGetterCall(getterArgs);
+        ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, property.As<v8::Value>());
+        profile.HostCall();
+        engine->NamedPropGetterCall(getterArgs.get());
+        profile.HostDone();
         if (getterArgs->error != "")
             engine->Throw_Exception(getterArgs->error.c_str());
     }
@@ -748,9 +1648,15 @@ void IEngine::IndexedPropSetter(unsigned int index, v8::Local<v8::Value> value,
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kIndexedSetter, v8::Local<v8::Value>());
 	if (engine->IndPropSetterCall) {
-		auto setterArgs = new ISetterArgs(info, index, value);
-		engine->IndPropSetterCall(setterArgs);
+		ArgsPool<ISetterArgs>::Scope setterArgs(engine->setterArgsPool, info, index, value);
+		double epoch = engine->scriptEpoch;
+		profile.HostCall();
+		engine->IndPropSetterCall(setterArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
+		engine->IndexedCacheSet(info, index, epoch);
 		if (setterArgs->error != "")
 			engine->Throw_Exception(setterArgs->error.c_str());
 	}
@@ -763,9 +1669,13 @@ void IEngine::NamedPropSetter(v8::Local<v8::String> property, v8::Local<v8::Valu
     if (!engine)
         return;
     v8::Isolate::Scope iso_scope(engine->isolate);
+    IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kNamedSetter, v8::Local<v8::Value>());
     if (engine->NamedPropSetterCall) {
-        auto setterArgs = new ISetterArgs(info, property, value);
-        engine->NamedPropSetterCall(setterArgs);
+        ArgsPool<ISetterArgs>::Scope setterArgs(engine->setterArgsPool, info, property.As<v8::Value>(), value);
+        profile.HostCall();
+        engine->NamedPropSetterCall(setterArgs.get());
+        profile.HostDone();
+        engine->BumpScriptEpoch();
         if (setterArgs->error != "")
             engine->Throw_Exception(setterArgs->error.c_str());
     }
@@ -777,10 +1687,12 @@ void IEngine::FieldGetter(v8::Local<v8::String> property, const v8::PropertyCall
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kFieldGetter, info.Data());
 	if (engine->fieldGetterCall) {
-		v8::String::Utf8Value str(property);
-		auto getterArgs = new IGetterArgs(info, *str);
-		engine->fieldGetterCall(getterArgs);
+		ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, property.As<v8::Name>());
+		profile.HostCall();
+		engine->fieldGetterCall(getterArgs.get());
+		profile.HostDone();
 		if (getterArgs->error != "")
 			engine->Throw_Exception(getterArgs->error.c_str());
 	}
@@ -793,10 +1705,13 @@ void IEngine::FieldSetter(v8::Local<v8::String> property, v8::Local<v8::Value> v
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kFieldSetter, info.Data());
 	if (engine->fieldSetterCall) {
-		v8::String::Utf8Value str(property);
-		auto setterArgs = new ISetterArgs(info, *str, value);
-		engine->fieldSetterCall(setterArgs);
+		ArgsPool<ISetterArgs>::Scope setterArgs(engine->setterArgsPool, info, property.As<v8::Name>(), value);
+		profile.HostCall();
+		engine->fieldSetterCall(setterArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
 		if (setterArgs->error != "")
 			engine->Throw_Exception(setterArgs->error.c_str());
 	}
@@ -808,10 +1723,12 @@ void IEngine::Getter(v8::Local<v8::String> property, const v8::PropertyCallbackI
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kGetter, info.Data());
 	if (engine->getterCall) {
-		v8::String::Utf8Value str(property);
-		auto getterArgs = new IGetterArgs(info, *str);
-		engine->getterCall(getterArgs);
+		ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, property.As<v8::Name>());
+		profile.HostCall();
+		engine->getterCall(getterArgs.get());
+		profile.HostDone();
 		if (getterArgs->error != "")
 			engine->Throw_Exception(getterArgs->error.c_str());
 	}
@@ -823,10 +1740,13 @@ void IEngine::Setter(v8::Local<v8::String> property, v8::Local<v8::Value> value,
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kSetter, info.Data());
 	if (engine->setterCall) {
-		v8::String::Utf8Value str(property);
-		auto setterArgs = new ISetterArgs(info, *str, value);
-		engine->setterCall(setterArgs);
+		ArgsPool<ISetterArgs>::Scope setterArgs(engine->setterArgsPool, info, property.As<v8::Name>(), value);
+		profile.HostCall();
+		engine->setterCall(setterArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
 		if (setterArgs->error != "")
 			engine->Throw_Exception(setterArgs->error.c_str());
 	}
@@ -838,10 +1758,12 @@ void IEngine::InterfaceGetter(v8::Local<v8::Name> property, const v8::PropertyCa
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kInterfaceGetter, v8::Local<v8::Value>());
 	if (engine->IFaceGetterPropCall) {
-		v8::String::Utf8Value str(property);
-		auto getterArgs = new IGetterArgs(info, *str);
-		engine->IFaceGetterPropCall(getterArgs);
+		ArgsPool<IGetterArgs>::Scope getterArgs(engine->getterArgsPool, info, property.As<v8::Name>());
+		profile.HostCall();
+		engine->IFaceGetterPropCall(getterArgs.get());
+		profile.HostDone();
 		if (getterArgs->error != "")
 			engine->Throw_Exception(getterArgs->error.c_str());
 	}
@@ -853,10 +1775,13 @@ void IEngine::InterfaceSetter(v8::Local<v8::Name> property, v8::Local<v8::Value>
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kInterfaceSetter, v8::Local<v8::Value>());
 	if (engine->IFaceSetterPropCall) {
-		v8::String::Utf8Value str(property);
-		auto setterArgs = new IIntfSetterArgs(info, *str, value);
-		engine->IFaceSetterPropCall(setterArgs);
+		ArgsPool<IIntfSetterArgs>::Scope setterArgs(engine->intfSetterArgsPool, info, property.As<v8::Name>(), value);
+		profile.HostCall();
+		engine->IFaceSetterPropCall(setterArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
 		if (setterArgs->error != "")
 			engine->Throw_Exception(setterArgs->error.c_str());
 	}
@@ -868,9 +1793,13 @@ void IEngine::InterfaceFuncCallBack(const v8::FunctionCallbackInfo<v8::Value>& a
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kInterfaceMethod, v8::Local<v8::Value>());
 	if (engine->IFaceMethodCall) {
-		auto methodArgs = new IMethodArgs(args);
-		engine->IFaceMethodCall(methodArgs);
+		ArgsPool<IMethodArgs>::Scope methodArgs(engine->methodArgsPool, args);
+		profile.HostCall();
+		engine->IFaceMethodCall(methodArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
 		if (methodArgs->error != "")
 			engine->Throw_Exception(methodArgs->error.c_str());
 	}
@@ -882,9 +1811,13 @@ void IEngine::FuncCallBack(const v8::FunctionCallbackInfo<v8::Value>& args)
 	if (!engine)
 		return;
 	v8::Isolate::Scope iso_scope(engine->isolate);
+	IBridgeProfiler::Scope profile(engine->profiler, IBridgeProfiler::kMethod, args.Data());
 	if (engine->methodCall) {
-		auto methodArgs = new IMethodArgs(args);
-		engine->methodCall(methodArgs);
+		ArgsPool<IMethodArgs>::Scope methodArgs(engine->methodArgsPool, args);
+		profile.HostCall();
+		engine->methodCall(methodArgs.get());
+		profile.HostDone();
+		engine->BumpScriptEpoch();
 		if (methodArgs->error != "")
 			engine->Throw_Exception(methodArgs->error.c_str());
 	}
@@ -902,10 +1835,13 @@ void IEngine::toStringCallBack(const v8::FunctionCallbackInfo<v8::Value>& args)
         auto dObject = reinterpret_cast<uintptr_t>(engine->GetDelphiObject(js_object));
         auto dClasstype = reinterpret_cast<uintptr_t>(engine->GetDelphiClasstype(js_object));
 
-        v8::String::Utf8Value cTypeName(js_object->GetConstructorName());
-        std::string str = "[object " + std::string(*cTypeName) + "] " + std::to_string(dObject) + dObjectToStringDelimiter + std::to_string(dClasstype);
-        args.GetReturnValue().Set(v8::String::NewFromUtf8(iso, str.c_str(), v8::NewStringType::kNormal).ToLocalChecked());
-        
+        char ids[64];
+        snprintf(ids, sizeof(ids), "] %llu%s%llu", (unsigned long long)dObject, dObjectToStringDelimiter, (unsigned long long)dClasstype);
+        auto str = v8::String::Concat(v8::String::NewFromUtf8(iso, dObjectToStringPrefix, v8::NewStringType::kNormal).ToLocalChecked(),
+            js_object->GetConstructorName());
+        str = v8::String::Concat(str, v8::String::NewFromUtf8(iso, ids, v8::NewStringType::kNormal).ToLocalChecked());
+        args.GetReturnValue().Set(str);
+
     }
 }
 
@@ -938,26 +1874,23 @@ IEngine * IEngine::GetEngine(v8::Isolate * iso)
 }
 
 inline void IObjectTemplate::SetMethod(char * methodName, void * methodCall) {
-	auto method = std::make_unique<IObjectMethod>();
-	method->name = methodName;
-	method->call = methodCall;
-	methods.push_back(std::move(method));
+	SetMethodWithId(methodName, methodCall, -1);
 }
 
 inline void IObjectTemplate::SetProp(char * propName, void * propObj, bool read, bool write) {
-	auto newProp = std::make_unique<IObjectProp>(propName, propObj, read, write);
-	props.push_back(std::move(newProp));
+	SetPropWithId(propName, propObj, read, write, -1);
 }
 
 void IObjectTemplate::SetIndexedProp(char * propName, void * propObj, bool read, bool write)
 {
 	auto newProp = std::make_unique<IObjectProp>(propName, propObj, read, write);
+	newProp->owner = this;
 	ind_props.push_back(std::move(newProp));
 }
 
 void IObjectTemplate::SetField(char * fieldName)
 {
-	fields.push_back(fieldName);
+	SetFieldWithId(fieldName, -1);
 }
 
 void IObjectTemplate::SetEnumField(char * valuename, int value)
@@ -973,6 +1906,31 @@ void IObjectTemplate::SetHasIndexedProps(bool hasIndProps)
 
 void IObjectTemplate::SetParent(IObjectTemplate * parent)
 {
+	this->parent = parent;
+}
+
+void IObjectTemplate::SetMethodWithId(char * methodName, void * methodCall, int id)
+{
+	auto method = std::make_unique<IObjectMethod>();
+	method->name = methodName;
+	method->call = methodCall;
+	method->id = id;
+	method->owner = this;
+	methods.push_back(std::move(method));
+}
+
+void IObjectTemplate::SetPropWithId(char * propName, void * propObj, bool read, bool write, int id)
+{
+	auto newProp = std::make_unique<IObjectProp>(propName, propObj, read, write, id);
+	newProp->owner = this;
+	props.push_back(std::move(newProp));
+}
+
+void IObjectTemplate::SetFieldWithId(char * fieldName, int id)
+{
+	auto newField = std::make_unique<IObjectProp>(fieldName, nullptr, true, true, id);
+	newField->owner = this;
+	fields.push_back(std::move(newField));
 }
 
 IObjectTemplate::IObjectTemplate(std::string objclasstype, v8::Isolate * isolate)
@@ -993,7 +1951,7 @@ void IObjectProp::setName(char * Aname)
 	name = Aname;
 }
 
-inline IObjectProp::IObjectProp(std::string pName, void * pObj, bool pRead, bool Pwrite) { name = pName; read = pRead; write = Pwrite; obj = pObj; }
+inline IObjectProp::IObjectProp(std::string pName, void * pObj, bool pRead, bool Pwrite, int pId) { name = pName; read = pRead; write = Pwrite; obj = pObj; id = pId; }
 
 inline IObjectProp::IObjectProp() {}
 
@@ -1018,11 +1976,10 @@ inline bool IValue::ArgIsString() {
 
 bool IValue::ArgIsObject()
 {
-    auto result = GetV8Value()->IsObject();
-    if (!result)
-        if (GetObjectFromString())
-            result = true;
-    return result;
+    auto value = GetV8Value();
+    if (value->IsObject())
+        return true;
+    return value->IsString() && GetObjectFromString();
 }
 bool IValue::ArgIsArray()
 {
@@ -1054,13 +2011,17 @@ inline bool IValue::GetArgAsBool() {
 	return GetV8Value()->BooleanValue(GetCurrentContext()).FromMaybe(false);
 }
 
+int IValue::GetArgAsUnicodeString(uint16_t * buf, int len)
+{
+	v8::Isolate::Scope scope(Isolate());
+	return WriteUnicode(Isolate(), GetV8Value(), buf, len);
+}
+
 inline char * IValue::GetArgAsString() {
 	v8::Isolate::Scope scope(Isolate());
+	InvalidateForConversion(Isolate(), GetV8Value());
 	v8::String::Utf8Value str(GetV8Value()->ToString());
-	char *it1 = *str;
-	char *it2 = *str + str.length();
-	auto vec = std::vector<char>(it1, it2);
-	run_string_result = vec;
+	run_string_result.assign(*str, *str + str.length());
 	run_string_result.push_back(0);
 	return run_string_result.data();
 }
@@ -1071,10 +2032,8 @@ IObject * IValue::GetArgAsObject()
 	if (!obj) {
 		auto arg = GetV8Value();
 		if (arg->IsObject()) {
-			auto maybeobj = arg->ToObject(GetCurrentContext());
-			if (maybeobj.IsEmpty())
-				return nullptr;
-			obj = new IObject(Isolate(), maybeobj.ToLocalChecked());
+			own_obj = std::make_unique<IObject>(Isolate(), arg.As<v8::Object>());
+			obj = own_obj.get();
 		}
 		else
 			obj = GetObjectFromString();
@@ -1085,8 +2044,10 @@ IObject * IValue::GetArgAsObject()
 IValueArray * IValue::GetArgAsArray()
 {
 	v8::Isolate::Scope scope(Isolate());
-	if (!arr)
-		arr = new IValueArray(Isolate(), v8::Local<v8::Array>::Cast(GetV8Value()));
+	if (!arr) {
+		own_arr = std::make_unique<IValueArray>(Isolate(), v8::Local<v8::Array>::Cast(GetV8Value()));
+		arr = own_arr.get();
+	}
 	return arr;
 }
 
@@ -1095,8 +2056,10 @@ IRecord * IValue::GetArgAsRecord()
 	if (!rec) {
 		if (GetV8Value()->IsExternal())
 			rec = static_cast<IRecord *>(GetV8Value().As<v8::External>()->Value());
-		else
-			rec = new IRecord(Isolate(), GetV8Value()->ToObject(GetCurrentContext()).ToLocalChecked());
+		else {
+			own_rec = std::make_unique<IRecord>(Isolate(), GetV8Value()->ToObject(GetCurrentContext()).ToLocalChecked());
+			rec = own_rec.get();
+		}
 	};
 	return rec;
 }
@@ -1104,31 +2067,74 @@ IRecord * IValue::GetArgAsRecord()
 IFunction * IValue::GetArgAsFunction()
 {
 	if (!func) {
-		func = new IFunction(GetV8Value().As<v8::Function>(), Isolate());
+		own_func = std::make_unique<IFunction>(GetV8Value().As<v8::Function>(), Isolate());
+		func = own_func.get();
 	}
 	return func;
 }
 
+IValue * IValue::Detach()
+{
+	IEngine * eng = IEngine::GetEngine(Isolate());
+	if (!eng)
+		return nullptr;
+	return eng->KeepDetachedValue(GetV8Value());
+}
+
+int IValue::GetArgAsTypedArray(void ** data, size_t * len)
+{
+	auto value = GetV8Value();
+	if (!value->IsTypedArray())
+		return TypedArrayNone;
+	auto arr = value.As<v8::TypedArray>();
+	// Buffer() moves small on-heap arrays to off-heap store, so data pointer stays valid
+	auto contents = arr->Buffer()->GetContents();
+	*data = static_cast<char *>(contents.Data()) + arr->ByteOffset();
+	if (arr->IsFloat64Array()) {
+		*len = arr->Length();
+		return TypedArrayFloat64;
+	}
+	if (arr->IsInt32Array()) {
+		*len = arr->Length();
+		return TypedArrayInt32;
+	}
+	*len = arr->ByteLength();
+	return TypedArrayOther;
+}
+
 int IValue::GetIndex()
 {
 	return ind;
 }
 
+void IValue::Reset(v8::Local<v8::Value> val, int index)
+{
+	SetLocalV8Value(val);
+	ind = index;
+	obj = nullptr;
+	arr = nullptr;
+	rec = nullptr;
+	func = nullptr;
+	own_obj.reset();
+	own_arr.reset();
+	own_rec.reset();
+	own_func.reset();
+}
+
+//string, made by toString() of wrapper, is resolved only to wrapper from engine's cache (nullptr
+//if it isn't there): pointers, parsed from script's string, are never given to host or wrapped
 IObject * IValue::GetObjectFromString()
 {
-    std::regex objectString("\\[object *(\\w+)\\] *(\\d+) *(\\d+)");
-    if (!obj) {
-        if (GetV8Value()->IsString()) {
-            v8::Isolate::Scope iso_scope(Isolate());
-            v8::String::Utf8Value strUTF8(GetV8Value()->ToString());
-            std::string str = *strUTF8;
-            std::smatch match;
-            if (std::regex_search(str, match, objectString)) {
-                std::string match1 = match[2];
-                std::string match2 = match[3];
-                int dObjectPointer = std::atoi(match1.c_str());
-                int dClasstype = std::atoi(match2.c_str());
-                obj = IEngine::GetEngine(Isolate())->NewObject((void *)(dObjectPointer), (void *)dClasstype);
+    if (!obj && GetV8Value()->IsString()) {
+        v8::Isolate::Scope iso_scope(Isolate());
+        IEngine * engine = IEngine::GetEngine(Isolate());
+        uintptr_t dObject = 0;
+        uintptr_t dClasstype = 0;
+        if (engine && ParseObjectString(GetV8Value().As<v8::String>(), dObject, dClasstype)) {
+            auto wrapper = engine->FindObject(reinterpret_cast<void *>(dObject), reinterpret_cast<void *>(dClasstype), Isolate());
+            if (!wrapper.IsEmpty()) {
+                own_obj = std::make_unique<IObject>(Isolate(), wrapper);
+                obj = own_obj.get();
             }
         }
     }
@@ -1176,19 +2182,17 @@ inline char * IMethodArgs::GetMethodName() {
 	if (data->IsArray()) {
 		auto val = data.As<v8::Array>()->Get(iso->GetCurrentContext(), 1).ToLocalChecked();
 		v8::String::Utf8Value str(val);
-		char *it1 = *str;
-		char *it2 = *str + str.length();
-		auto vec = std::vector<char>(it1, it2);
-		run_string_result = vec;
+		run_string_result.assign(*str, *str + str.length());
 		run_string_result.push_back(0);
 		return run_string_result.data();
 	}
+	else if (data->IsExternal()) {
+		auto method = static_cast<IObjectMethod *>(data.As<v8::External>()->Value());
+		return const_cast<char *>(method->name.c_str());
+	}
 	else {
 		v8::String::Utf8Value str(args->Callee()->GetName());
-		char *it1 = *str;
-		char *it2 = *str + str.length();
-		auto vec = std::vector<char>(it1, it2);
-		run_string_result = vec;
+		run_string_result.assign(*str, *str + str.length());
 		run_string_result.push_back(0);
 		return run_string_result.data();
 	}
@@ -1255,6 +2259,28 @@ void IMethodArgs::SetReturnValueString(char * val)
 	args->GetReturnValue().Set<v8::String>(str);
 }
 
+void IMethodArgs::SetReturnValueUnicode(uint16_t * val, int len)
+{
+	args->GetReturnValue().Set(NewUnicodeString(args->GetIsolate(), val, len));
+}
+
+int IMethodArgs::GetMethodNameUnicode(uint16_t * buf, int len)
+{
+	v8::Isolate * iso = args->GetIsolate();
+	auto data = args->Data();
+	v8::Local<v8::Value> name;
+	if (data->IsArray())
+		name = data.As<v8::Array>()->Get(iso->GetCurrentContext(), 1).ToLocalChecked();
+	else if (data->IsExternal()) {
+		auto method = static_cast<IObjectMethod *>(data.As<v8::External>()->Value());
+		name = v8::String::NewFromUtf8(iso, method->name.c_str(), v8::NewStringType::kNormal).ToLocalChecked();
+	}
+	//data of method is always one of these forms
+	else
+		return 0;
+	return WriteUnicode(iso, name, buf, len);
+}
+
 void IMethodArgs::SetReturnValueDouble(double val)
 {
 	args->GetReturnValue().Set(val);
@@ -1268,17 +2294,15 @@ void IMethodArgs::SetReturnValue(IBaseValue * val)
 
 IValue * IMethodArgs::GetArg(int index)
 {
-	for (auto &val : values) {
-		if (val->GetIndex() == index)
-			return val.get();
-	}
+	if (index >= 0 && index < valuesCount)
+		return values[index].get();
 	return nullptr;
 }
 
 void * IMethodArgs::GetDelphiMethod()
 {
 	if (args->Data()->IsExternal()) {
-		return args->Data().As<v8::External>()->Value();
+		return static_cast<IObjectMethod *>(args->Data().As<v8::External>()->Value())->call;
 	}
 	if (args->Data()->IsUndefined()) {
 		std::cout << "FuncData is undefined, WTF??";
@@ -1291,6 +2315,14 @@ void IMethodArgs::SetError(char * errorMsg)
 	error = errorMsg;
 }
 
+int IMethodArgs::GetMethodId()
+{
+	auto data = args->Data();
+	if (data->IsExternal())
+		return static_cast<IObjectMethod *>(data.As<v8::External>()->Value())->id;
+	return -1;
+}
+
 void * IMethodArgs::GetEngine()
 {
 	IEngine * engine = IEngine::GetEngine(iso);
@@ -1299,18 +2331,30 @@ void * IMethodArgs::GetEngine()
 	return engine->DEngine;
 }
 
-inline IMethodArgs::IMethodArgs(const v8::FunctionCallbackInfo<v8::Value>& newArgs) {
+IMethodArgs::IMethodArgs()
+{
+}
+
+IMethodArgs::IMethodArgs(const v8::FunctionCallbackInfo<v8::Value>& newArgs) {
+	Reset(newArgs);
+}
+
+void IMethodArgs::Reset(const v8::FunctionCallbackInfo<v8::Value>& newArgs)
+{
 	args = &newArgs;
 	iso = args->GetIsolate();
-	for (int i = 0; i < args->Length(); i++) {
-		auto val = std::make_unique<IValue>(args->GetIsolate(), (*args)[i], i);
-		values.push_back(std::move(val));
+	error.clear();
+	valuesCount = args->Length();
+	for (int i = 0; i < valuesCount; i++) {
+		if (static_cast<size_t>(i) == values.size())
+			values.push_back(std::make_unique<IValue>(iso, v8::Local<v8::Value>(), i));
+		values[i]->Reset((*args)[i], i);
 	}
 }
 
 IObject::IObject(v8::Isolate * isolate, v8::Local<v8::Object> object): IBaseValue(isolate, object)
 {
-	isDObject = (object->InternalFieldCount() > 0 ? object->GetInternalField(DelphiObjectIndex)->IsExternal() : false);
+	isDObject = IsDelphiWrapper(object);
 }
 
 bool IObject::IsDelphiObject()
@@ -1321,12 +2365,9 @@ bool IObject::IsDelphiObject()
 void * IObject::GetDelphiObject()
 {
 	if (isDObject) {
-         auto maybeObj = GetV8Value()->ToObject(GetCurrentContext());
-         if (!maybeObj.IsEmpty()) {
-             auto objField = maybeObj.ToLocalChecked()->GetInternalField(DelphiObjectIndex);
-             if (objField->IsExternal())
-                 return objField.As<v8::External>()->Value();
-         }
+		auto objField = GetV8Value().As<v8::Object>()->GetInternalField(DelphiObjectIndex);
+		if (objField->IsExternal())
+			return objField.As<v8::External>()->Value();
 	}
 	return nullptr;
 }
@@ -1334,12 +2375,9 @@ void * IObject::GetDelphiObject()
 void * IObject::GetDelphiClasstype()
 {
 	if (isDObject) {
-        auto maybeObj = GetV8Value()->ToObject(GetCurrentContext());
-        if (!maybeObj.IsEmpty()) {
-            auto objField = maybeObj.ToLocalChecked()->GetInternalField(DelphiClassTypeIndex);
-            if (objField->IsExternal())
-                return objField.As<v8::External>()->Value();
-        }
+		auto objField = GetV8Value().As<v8::Object>()->GetInternalField(DelphiClassTypeIndex);
+		if (objField->IsExternal())
+			return objField.As<v8::External>()->Value();
 	}
 	return nullptr;
 }
@@ -1372,6 +2410,7 @@ IBaseValue * IValueArray::GetValue(int index)
 	if (result)
 		return result;
 	else {
+		v8::HandleScope handle_scope(Isolate());
 		values[index] = std::make_unique<IValue>(Isolate(), GetV8Array()->Get(GetCurrentContext(), index).ToLocalChecked(), index);
 		return values[index].get();
 	}
@@ -1380,6 +2419,7 @@ IBaseValue * IValueArray::GetValue(int index)
 
 void IValueArray::SetValue(IBaseValue * value, int index)
 {
+	v8::HandleScope handle_scope(Isolate());
 	auto v8_array = GetV8Array();
 	v8_array->Set(GetCurrentContext(), index, value->GetV8Value());
 }
@@ -1402,27 +2442,88 @@ v8::Local<v8::Array> IValueArray::GetV8Array()
 }
 
 IGetterArgs::IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop)
+{
+	Reset(info, prop);
+}
+
+IGetterArgs::IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index)
+{
+	Reset(info, index);
+}
+
+IGetterArgs::IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index)
+{
+	Reset(info, index);
+}
+
+IGetterArgs::IGetterArgs()
+{
+}
+
+void IGetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop)
 {
 	IsIndexedProp = false;
 	propinfo = &info;
 	propName = prop;
+	propNameValue.Clear();
+	propInd = -1;
+	indexValue = nullptr;
 	iso = info.GetIsolate();
+	rangeCount = 0;
+	rangeValues.Clear();
+	error.clear();
 }
 
-IGetterArgs::IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index)
+void IGetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Name> prop)
+{
+	IsIndexedProp = false;
+	propinfo = &info;
+	propName.clear();
+	propNameValue = prop;
+	propInd = -1;
+	indexValue = nullptr;
+	iso = info.GetIsolate();
+	rangeCount = 0;
+	rangeValues.Clear();
+	error.clear();
+}
+
+void IGetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index)
 {
-    IsIndexedProp = true;
-    propinfo = &info;
-    iso = info.GetIsolate();
-    indexValue = new IValue(iso, index, -1);
+	IsIndexedProp = true;
+	propinfo = &info;
+	propName.clear();
+	propNameValue.Clear();
+	propInd = -1;
+	iso = info.GetIsolate();
+	if (!own_index_value)
+		own_index_value = std::make_unique<IValue>(iso, v8::Local<v8::Value>(), -1);
+	own_index_value->Reset(index, -1);
+	indexValue = own_index_value.get();
+	rangeCount = 0;
+	rangeValues.Clear();
+	error.clear();
 }
 
-IGetterArgs::IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index)
+void IGetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index)
 {
 	IsIndexedProp = true;
 	propinfo = &info;
+	propName.clear();
+	propNameValue.Clear();
 	propInd = index;
+	indexValue = nullptr;
 	iso = info.GetIsolate();
+	rangeCount = 0;
+	rangeValues.Clear();
+	error.clear();
+}
+
+void IGetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index, int count)
+{
+	Reset(info, index);
+	rangeCount = count;
+	rangeLength = -1;
 }
 
 void * IGetterArgs::GetDelphiObject()
@@ -1430,7 +2531,7 @@ void * IGetterArgs::GetDelphiObject()
 	IEngine * eng = IEngine::GetEngine(iso);
 	if (!eng)
 		return nullptr;
-	auto holder = propinfo->Holder();
+	auto holder = WrapperHolder(*propinfo);
 	return eng->GetDelphiObject(holder);
 }
 
@@ -1439,16 +2540,17 @@ void * IGetterArgs::GetDelphiClasstype()
 	IEngine * eng = IEngine::GetEngine(iso);
 	if (!eng)
 		return nullptr;
-	auto holder = propinfo->Holder();
+	auto holder = WrapperHolder(*propinfo);
 	return eng->GetDelphiClasstype(holder);
 }
 
 char * IGetterArgs::GetPropName()
 {
-	auto vec = std::vector<char>(propName.begin(), propName.end());
-	run_string_result = vec;
-	run_string_result.push_back(0);
-	return run_string_result.data();
+	if (!propNameValue.IsEmpty()) {
+		WritePropName(propNameValue, propName);
+		propNameValue.Clear();
+	}
+	return &propName[0];
 }
 
 int IGetterArgs::GetPropIndex()
@@ -1533,6 +2635,11 @@ void IGetterArgs::SetGetterResultString(char * val)
 	propinfo->GetReturnValue().Set<v8::String>(str);
 }
 
+void IGetterArgs::SetGetterResultUnicode(uint16_t * val, int len)
+{
+	propinfo->GetReturnValue().Set(NewUnicodeString(propinfo->GetIsolate(), val, len));
+}
+
 void IGetterArgs::SetGetterResultDouble(double val)
 {
 	propinfo->GetReturnValue().Set(val);
@@ -1570,6 +2677,29 @@ void IGetterArgs::SetError(char * errorMsg)
 	error = errorMsg;
 }
 
+int IGetterArgs::GetPropId()
+{
+	if (IsIndexedProp)
+		return -1;
+	return GetMemberId(propinfo->Data());
+}
+
+int IGetterArgs::GetRangeCount()
+{
+	return rangeCount;
+}
+
+void IGetterArgs::SetRangeResult(IBaseValue * values, int length)
+{
+	if (!values || rangeCount == 0)
+		return;
+	auto val = values->GetV8Value();
+	if (val->IsArray() || val->IsTypedArray()) {
+		rangeValues = val;
+		rangeLength = length;
+	}
+}
+
 void * IGetterArgs::GetEngine()
 {
 	IEngine * engine = IEngine::GetEngine(iso);
@@ -1579,33 +2709,87 @@ void * IGetterArgs::GetEngine()
 }
 
 ISetterArgs::ISetterArgs(const v8::PropertyCallbackInfo<void>& info, char * prop, v8::Local<v8::Value> newValue)
+{
+	Reset(info, prop, newValue);
+}
+
+ISetterArgs::ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index, v8::Local<v8::Value> newValue)
+{
+	Reset(info, index, newValue);
+}
+
+ISetterArgs::ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index, v8::Local<v8::Value> newValue)
+{
+	Reset(info, index, newValue);
+}
+
+ISetterArgs::ISetterArgs()
+{
+}
+
+void ISetterArgs::Reset(const v8::PropertyCallbackInfo<void>& info, char * prop, v8::Local<v8::Value> newValue)
 {
 	IsIndexedProp = false;
 	propName = prop;
+	propNameValue.Clear();
+	propInd = -1;
 	propinfo = &info;
+	indexedPropInfo = nullptr;
+	indexVal = nullptr;
 	iso = info.GetIsolate();
-	newVal = newValue;
-	setterVal = new IValue(iso, newVal, 0);
+	SetNewValue(newValue);
 }
 
-ISetterArgs::ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index, v8::Local<v8::Value> newValue)
+void ISetterArgs::Reset(const v8::PropertyCallbackInfo<void>& info, v8::Local<v8::Name> prop, v8::Local<v8::Value> newValue)
 {
-    IsIndexedProp = true;
-    indexedPropInfo = &info;
-    iso = info.GetIsolate();
-    indexVal = new IValue(iso, index, -1);
-    newVal = newValue;
-    setterVal = new IValue(iso, newVal, 0);
+	IsIndexedProp = false;
+	propName.clear();
+	propNameValue = prop;
+	propInd = -1;
+	propinfo = &info;
+	indexedPropInfo = nullptr;
+	indexVal = nullptr;
+	iso = info.GetIsolate();
+	SetNewValue(newValue);
 }
 
-ISetterArgs::ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index, v8::Local<v8::Value> newValue)
+void ISetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index, v8::Local<v8::Value> newValue)
 {
 	IsIndexedProp = true;
+	propName.clear();
+	propNameValue.Clear();
+	propInd = -1;
+	propinfo = nullptr;
+	indexedPropInfo = &info;
+	iso = info.GetIsolate();
+	if (!own_index_value)
+		own_index_value = std::make_unique<IValue>(iso, v8::Local<v8::Value>(), -1);
+	own_index_value->Reset(index, -1);
+	indexVal = own_index_value.get();
+	SetNewValue(newValue);
+}
+
+void ISetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index, v8::Local<v8::Value> newValue)
+{
+	IsIndexedProp = true;
+	propName.clear();
+	propNameValue.Clear();
 	propInd = index;
+	propinfo = nullptr;
 	indexedPropInfo = &info;
+	indexVal = nullptr;
 	iso = info.GetIsolate();
+	SetNewValue(newValue);
+}
+
+void ISetterArgs::SetNewValue(v8::Local<v8::Value> newValue)
+{
 	newVal = newValue;
-	setterVal = new IValue(iso, newVal, 0);
+	if (!own_setter_value)
+		own_setter_value = std::make_unique<IValue>(iso, v8::Local<v8::Value>(), 0);
+	own_setter_value->Reset(newVal, 0);
+	setterVal = own_setter_value.get();
+	error.clear();
 }
 
 void * ISetterArgs::GetEngine()
@@ -1626,7 +2810,7 @@ void * ISetterArgs::GetDelphiObject()
 		holder = indexedPropInfo->Holder();
 	}
 	else {
-		holder = propinfo->Holder();
+		holder = WrapperHolder(*propinfo);
 	}
 	return eng->GetDelphiObject(holder);
 }
@@ -1641,17 +2825,18 @@ void * ISetterArgs::GetDelphiClasstype()
 		holder = indexedPropInfo->Holder();
 	}
 	else {
-		holder = propinfo->Holder();
+		holder = WrapperHolder(*propinfo);
 	}
 	return eng->GetDelphiClasstype(holder);
 }
 
 char * ISetterArgs::GetPropName()
 {
-	auto vec = std::vector<char>(propName.begin(), propName.end());
-	run_string_result = vec;
-	run_string_result.push_back(0);
-	return run_string_result.data();
+	if (!propNameValue.IsEmpty()) {
+		WritePropName(propNameValue, propName);
+		propNameValue.Clear();
+	}
+	return &propName[0];
 }
 
 int ISetterArgs::GetPropIndex()
@@ -1696,14 +2881,16 @@ bool ISetterArgs::GetValueAsBool()
 char * ISetterArgs::GetValueAsString()
 {
 	v8::String::Utf8Value str(newVal);
-	char *it1 = *str;
-	char *it2 = *str + str.length();
-	auto vec = std::vector<char>(it1, it2);
-	run_string_result = vec;
+	run_string_result.assign(*str, *str + str.length());
 	run_string_result.push_back(0);
 	return run_string_result.data();
 }
 
+int ISetterArgs::GetValueAsUnicodeString(uint16_t * buf, int len)
+{
+	return WriteUnicode(iso, newVal, buf, len);
+}
+
 double ISetterArgs::GetValueAsDouble()
 {
 	return newVal->NumberValue(iso->GetCurrentContext()).FromMaybe(0.0);
@@ -1817,6 +3004,85 @@ void ISetterArgs::SetError(char * errorMsg)
 	error = errorMsg;
 }
 
+int ISetterArgs::GetPropId()
+{
+	if (IsIndexedProp)
+		return -1;
+	return GetMemberId(propinfo->Data());
+}
+
+v8::Local<v8::String> IEngine::InternName(const char * name)
+{
+	auto it = internedNames.find(name);
+	if (it != internedNames.end())
+		return it->second.Get(isolate);
+	auto result = v8::String::NewFromUtf8(isolate, name, v8::NewStringType::kInternalized).ToLocalChecked();
+	// names, made by scripts' data (e.g. record fields), mustn't grow cache without limit
+	if (internedNames.size() < kMaxInternedNames)
+		internedNames.emplace(name, v8::Eternal<v8::String>(isolate, result));
+	return result;
+}
+
+v8::Local<v8::String> IEngine::InternName(v8::Isolate * iso, const char * name)
+{
+	IEngine * engine = GetEngine(iso);
+	if (engine && engine->isolate == iso)
+		return engine->InternName(name);
+	return v8::String::NewFromUtf8(iso, name, v8::NewStringType::kInternalized).ToLocalChecked();
+}
+
+IRecordShape * IEngine::RecordShape(void * key)
+{
+	auto &shape = recordShapes[key];
+	if (!shape)
+		shape.reset(new IRecordShape(isolate));
+	return shape.get();
+}
+
+IRecord * IEngine::NewShapedRecord(IRecordShape * shape)
+{
+	v8::Isolate::Scope scope(isolate);
+	auto record = std::make_unique<IRecord>(isolate, shape->NewInstance(isolate->GetCurrentContext()));
+	record->SetShape(shape);
+	return Keep(std::move(record));
+}
+
+int IRecordShape::AddField(char * name)
+{
+	names.push_back(v8::Eternal<v8::String>(iso, IEngine::InternName(iso, name)));
+	templ.Reset();
+	return int(names.size()) - 1;
+}
+
+int IRecordShape::FieldCount()
+{
+	return int(names.size());
+}
+
+bool IRecordShape::FieldName(int index, v8::Local<v8::String> * name)
+{
+	if (index < 0 || size_t(index) >= names.size())
+		return false;
+	*name = names[index].Get(iso);
+	return true;
+}
+
+v8::Local<v8::Object> IRecordShape::NewInstance(v8::Local<v8::Context> context)
+{
+	v8::EscapableHandleScope scope(iso);
+	v8::Local<v8::ObjectTemplate> local;
+	if (templ.IsEmpty()) {
+		local = v8::ObjectTemplate::New(iso);
+		// fields are in template, so records don't change their map, when fields are set
+		for (auto &name : names)
+			local->Set(name.Get(iso), v8::Undefined(iso));
+		templ.Reset(iso, local);
+	}
+	else
+		local = v8::Local<v8::ObjectTemplate>::New(iso, templ);
+	return scope.Escape(local->NewInstance(context).ToLocalChecked());
+}
+
 IRecord::IRecord(v8::Isolate * isolate): IBaseValue(isolate)
 {
 	v8::Local<v8::Object> localObj = v8::Object::New(isolate);
@@ -1831,14 +3097,14 @@ void IRecord::SetIntField(char * name, int val)
 {
 	auto object = GetV8Object();
 	object->CreateDataProperty(GetCurrentContext(),
-		v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+		IEngine::InternName(Isolate(), name),
 		v8::Integer::New(Isolate(), val));
 }
 
 void IRecord::SetDoubleField(char * name, double val)
 {
 	auto object = GetV8Object();
-	object->Set(GetCurrentContext(), v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+	object->Set(GetCurrentContext(), IEngine::InternName(Isolate(), name),
 		v8::Number::New(Isolate(), val));
 }
 
@@ -1846,7 +3112,7 @@ void IRecord::SetBoolField(char * name, bool val)
 {
 	auto object = GetV8Object();
 	object->CreateDataProperty(GetCurrentContext(),
-		v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+		IEngine::InternName(Isolate(), name),
 		v8::Boolean::New(Isolate(), val));
 }
 
@@ -1854,7 +3120,7 @@ void IRecord::SetStringField(char * name, char * val)
 {
 	auto object = GetV8Object();
 	object->CreateDataProperty(GetCurrentContext(),
-		v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+		IEngine::InternName(Isolate(), name),
 		v8::String::NewFromUtf8(Isolate(), val, v8::NewStringType::kNormal).ToLocalChecked());
 }
 
@@ -1863,7 +3129,7 @@ void IRecord::SetObjectField(char * name, void * val)
 	if (val){
 		auto object = GetV8Object();
 		object->CreateDataProperty(GetCurrentContext(),
-			v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+			IEngine::InternName(Isolate(), name),
 			v8::External::New(Isolate(), val));
 	}
 }
@@ -1873,7 +3139,7 @@ void IRecord::SetValueField(char * name, IBaseValue * val)
     if (val) {
         auto object = GetV8Object();
         object->CreateDataProperty(GetCurrentContext(),
-            v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked(),
+            IEngine::InternName(Isolate(), name),
             val->GetV8Value());
     }
 }
@@ -1898,9 +3164,20 @@ bool IRecord::GetBoolField(char * name)
 
 char * IRecord::GetStringField(char * name)
 {
-    auto val = GetField(name);
+	return StringResult(GetField(name));
+}
+
+int IRecord::GetUnicodeStringField(char * name, uint16_t * buf, int len)
+{
+	v8::Isolate::Scope iso_scope(Isolate());
+	return WriteUnicode(Isolate(), GetField(name), buf, len);
+}
+
+char * IRecord::StringResult(v8::Local<v8::Value> val)
+{
     run_string_result = std::vector<char>();
     v8::Isolate::Scope iso_scope(Isolate());
+    InvalidateForConversion(Isolate(), val);
     auto maybeVal = val->ToString(GetCurrentContext());
     if (!maybeVal.IsEmpty()) {
         v8::String::Utf8Value str(maybeVal.ToLocalChecked());
@@ -1921,6 +3198,76 @@ void * IRecord::GetObjectField(char * name)
 	return nullptr;
 }
 
+void IRecord::SetShape(IRecordShape * shape)
+{
+	this->shape = shape;
+}
+
+void IRecord::SetFieldAt(int index, v8::Local<v8::Value> val)
+{
+	v8::Local<v8::String> name;
+	if (!shape || !shape->FieldName(index, &name))
+		return;
+	GetV8Object()->CreateDataProperty(GetCurrentContext(), name, val).FromJust();
+}
+
+v8::Local<v8::Value> IRecord::GetFieldAt(int index)
+{
+	v8::Local<v8::String> name;
+	if (!shape || !shape->FieldName(index, &name))
+		return v8::Undefined(Isolate());
+	v8::Local<v8::Value> result;
+	if (!GetV8Object()->Get(GetCurrentContext(), name).ToLocal(&result))
+		return v8::Undefined(Isolate());
+	return result;
+}
+
+void IRecord::SetIntFieldAt(int index, int val)
+{
+	SetFieldAt(index, v8::Integer::New(Isolate(), val));
+}
+
+void IRecord::SetDoubleFieldAt(int index, double val)
+{
+	SetFieldAt(index, v8::Number::New(Isolate(), val));
+}
+
+void IRecord::SetBoolFieldAt(int index, bool val)
+{
+	SetFieldAt(index, v8::Boolean::New(Isolate(), val));
+}
+
+void IRecord::SetStringFieldAt(int index, char * val)
+{
+	SetFieldAt(index, v8::String::NewFromUtf8(Isolate(), val, v8::NewStringType::kNormal).ToLocalChecked());
+}
+
+void IRecord::SetValueFieldAt(int index, IBaseValue * val)
+{
+	if (val)
+		SetFieldAt(index, val->GetV8Value());
+}
+
+int IRecord::GetIntFieldAt(int index)
+{
+	return GetFieldAt(index)->Int32Value(GetCurrentContext()).FromMaybe(0);
+}
+
+double IRecord::GetDoubleFieldAt(int index)
+{
+	return GetFieldAt(index)->NumberValue(GetCurrentContext()).FromMaybe(0.0);
+}
+
+bool IRecord::GetBoolFieldAt(int index)
+{
+	return GetFieldAt(index)->BooleanValue(GetCurrentContext()).FromMaybe(false);
+}
+
+char * IRecord::GetStringFieldAt(int index)
+{
+	return StringResult(GetFieldAt(index));
+}
+
 v8::Local<v8::Object> IRecord::GetV8Object()
 {
     return GetV8Value()->ToObject(GetCurrentContext()).ToLocalChecked();
@@ -1932,7 +3279,7 @@ v8::Local<v8::Value> IRecord::GetField(char * name)
     auto result = v8::Local<v8::Value>();
     auto object = GetV8Object();
     auto maybeVal = object->GetRealNamedProperty(GetCurrentContext(),
-        v8::String::NewFromUtf8(Isolate(), name, v8::NewStringType::kNormal).ToLocalChecked());
+        IEngine::InternName(Isolate(), name));
     if (!maybeVal.IsEmpty())
         result = maybeVal.ToLocalChecked();
     return result;
@@ -1994,6 +3341,10 @@ IValue * IFunction::CallFunction()
 		returnVal->Delete();
 		returnVal = nullptr;
 	}
+	//host could change indexed props before it fired the callback
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (engine)
+		engine->BumpScriptEpoch();
 	auto res = func.Get(iso)->Call(iso->GetCurrentContext(), func.Get(iso), argv.size(), argv.data());
 	if (!res.IsEmpty()) {
 		returnVal = new IValue(iso, res.ToLocalChecked(), 0);
@@ -2004,13 +3355,175 @@ IValue * IFunction::CallFunction()
 		return nullptr;
 }
 
+IPreparedCall::IPreparedCall(v8::Isolate * isolate, v8::Local<v8::Function> function)
+{
+	iso = isolate;
+	func.Reset(iso, function);
+}
+
+IPreparedCall::~IPreparedCall()
+{
+	func.Reset();
+}
+
+IValue * IPreparedCall::Call(IValueArray * args)
+{
+	v8::Isolate::Scope scope(iso);
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (engine)
+		engine->BumpScriptEpoch();
+	v8::Locker locker(iso);
+	v8::HandleScope handle_scope(iso);
+	auto context = iso->GetCurrentContext();
+	std::vector<v8::Local<v8::Value>> argv;
+	if (args)
+		argv = args->GeV8ValueVector();
+	int errors = 0;
+	auto res = CallOnce(context, func.Get(iso), argv.size(), argv.data(), errors);
+	if (res.IsEmpty())
+		return nullptr;
+	// the same IValue is given for every call
+	if (returnVal) {
+		returnVal->Reset(v8::Local<v8::Value>(), 0);
+		returnVal->SetV8Value(res.ToLocalChecked());
+	}
+	else
+		returnVal = std::make_unique<IValue>(iso, res.ToLocalChecked(), 0);
+	return returnVal.get();
+}
+
+IValueArray * IPreparedCall::CallBatch(IValueArray * argsBatch)
+{
+	v8::Isolate::Scope scope(iso);
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (!argsBatch) {
+		if (engine)
+			engine->LogErrorMessage("CallBatch: batch of args is null");
+		return nullptr;
+	}
+	if (engine)
+		engine->BumpScriptEpoch();
+	v8::Locker locker(iso);
+	v8::HandleScope handle_scope(iso);
+	auto context = iso->GetCurrentContext();
+	auto function = func.Get(iso);
+	auto batch = argsBatch->GetV8Array();
+	int count = batch->Length();
+	returnArr = std::make_unique<IValueArray>(iso, count);
+	auto results = returnArr->GetV8Array();
+	int errors = 0;
+	for (int i = 0; i < count; i++) {
+		v8::HandleScope handle_scope(iso);
+		std::vector<v8::Local<v8::Value>> argv;
+		// items and their args can be read by getters, which throw;
+		// such call is counted as failed and gets undefined as result
+		v8::TryCatch try_catch(iso);
+		v8::Local<v8::Value> item;
+		bool argsRead = batch->Get(context, i).ToLocal(&item);
+		if (argsRead && item->IsArray()) {
+			auto itemArgs = item.As<v8::Array>();
+			argv.resize(itemArgs->Length());
+			for (uint32_t j = 0; argsRead && j < argv.size(); j++)
+				argsRead = itemArgs->Get(context, j).ToLocal(&argv[j]);
+		}
+		else if (argsRead)
+			argv.push_back(item);
+		if (!argsRead) {
+			errors++;
+			results->Set(context, i, v8::Undefined(iso)).FromJust();
+			continue;
+		}
+		auto res = CallOnce(context, function, argv.size(), argv.data(), errors);
+		results->Set(context, i, res.IsEmpty() ? v8::Undefined(iso).As<v8::Value>() : res.ToLocalChecked()).FromJust();
+	}
+	return returnArr.get();
+}
+
+int IPreparedCall::CallBatchNumbers(double * args, int argsPerCall, int callsCount, double * results)
+{
+	v8::Isolate::Scope scope(iso);
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (argsPerCall <= 0 || callsCount <= 0 || !args || !results) {
+		if (engine)
+			engine->LogErrorMessage("CallBatchNumbers: wrong args or results");
+		return -1;
+	}
+	if (engine)
+		engine->BumpScriptEpoch();
+	v8::Locker locker(iso);
+	v8::HandleScope handle_scope(iso);
+	auto context = iso->GetCurrentContext();
+	auto function = func.Get(iso);
+	std::vector<v8::Local<v8::Value>> argv(argsPerCall);
+	int errors = 0;
+	for (int i = 0; i < callsCount; i++) {
+		v8::HandleScope handle_scope(iso);
+		for (int j = 0; j < argsPerCall; j++)
+			argv[j] = v8::Number::New(iso, args[size_t(i) * argsPerCall + j]);
+		auto res = CallOnce(context, function, argsPerCall, argv.data(), errors);
+		if (res.IsEmpty())
+			results[i] = std::numeric_limits<double>::quiet_NaN();
+		else
+			results[i] = res.ToLocalChecked()->NumberValue(context).FromMaybe(std::numeric_limits<double>::quiet_NaN());
+	}
+	return errors;
+}
+
+v8::MaybeLocal<v8::Value> IPreparedCall::CallOnce(v8::Local<v8::Context> context, v8::Local<v8::Function> function,
+	int argc, v8::Local<v8::Value>* argv, int & errors)
+{
+	// exception of one call shouldn't stop the batch, so it is caught here;
+	// only first error is sent to host's log
+	v8::TryCatch try_catch(iso);
+	auto res = function->Call(context, context->Global(), argc, argv);
+	if (try_catch.HasCaught()) {
+		if (errors == 0) {
+			IEngine * engine = IEngine::GetEngine(iso);
+			v8::String::Utf8Value error(try_catch.Exception());
+			if (engine && *error)
+				engine->LogErrorMessage(*error);
+		}
+		errors++;
+		return v8::MaybeLocal<v8::Value>();
+	}
+	return res;
+}
+
 IIntfSetterArgs::IIntfSetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop, v8::Local<v8::Value> newValue)
+{
+	Reset(info, prop, newValue);
+}
+
+IIntfSetterArgs::IIntfSetterArgs()
+{
+}
+
+void IIntfSetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop, v8::Local<v8::Value> newValue)
 {
 	propName = prop;
+	propNameValue.Clear();
 	IntfPropInfo = &info;
 	iso = info.GetIsolate();
 	newVal = newValue;
-	setterVal = new IValue(iso, newVal, 0);
+	if (!own_setter_value)
+		own_setter_value = std::make_unique<IValue>(iso, v8::Local<v8::Value>(), 0);
+	own_setter_value->Reset(newVal, 0);
+	setterVal = own_setter_value.get();
+	error.clear();
+}
+
+void IIntfSetterArgs::Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Name> prop, v8::Local<v8::Value> newValue)
+{
+	propName.clear();
+	propNameValue = prop;
+	IntfPropInfo = &info;
+	iso = info.GetIsolate();
+	newVal = newValue;
+	if (!own_setter_value)
+		own_setter_value = std::make_unique<IValue>(iso, v8::Local<v8::Value>(), 0);
+	own_setter_value->Reset(newVal, 0);
+	setterVal = own_setter_value.get();
+	error.clear();
 }
 
 void * IIntfSetterArgs::GetEngine()
@@ -2033,10 +3546,11 @@ void * IIntfSetterArgs::GetDelphiObject()
 
 char * IIntfSetterArgs::GetPropName()
 {
-	auto vec = std::vector<char>(propName.begin(), propName.end());
-	run_string_result = vec;
-	run_string_result.push_back(0);
-	return run_string_result.data();
+	if (!propNameValue.IsEmpty()) {
+		WritePropName(propNameValue, propName);
+		propNameValue.Clear();
+	}
+	return &propName[0];
 }
 
 IValue * IIntfSetterArgs::GetValue()
@@ -2071,10 +3585,7 @@ bool IIntfSetterArgs::GetValueAsBool()
 char * IIntfSetterArgs::GetValueAsString()
 {
 	v8::String::Utf8Value str(newVal);
-	char *it1 = *str;
-	char *it2 = *str + str.length();
-	auto vec = std::vector<char>(it1, it2);
-	run_string_result = vec;
+	run_string_result.assign(*str, *str + str.length());
 	run_string_result.push_back(0);
 	return run_string_result.data();
 }
@@ -2095,16 +3606,30 @@ IBaseValue::IBaseValue(v8::Isolate * isolate, v8::Local<v8::Value> value)
     v8Value.Reset(isolate, value);
 }
 
+IBaseValue::~IBaseValue()
+{
+    v8Value.Reset();
+}
+
 v8::Local<v8::Value> IBaseValue::GetV8Value()
 {
+    if (!localValue.IsEmpty())
+        return localValue;
     return v8Value.Get(iso);
 }
 
 void IBaseValue::SetV8Value(v8::Local<v8::Value> value)
 {
+    localValue.Clear();
     v8Value.Reset(iso, value);
 }
 
+void IBaseValue::SetLocalV8Value(v8::Local<v8::Value> value)
+{
+    v8Value.Reset();
+    localValue = value;
+}
+
 v8::Isolate * IBaseValue::Isolate()
 {
     return iso;
@@ -2156,4 +3681,39 @@ IValue * IBaseValue::AsValue()
     return dynamic_cast<IValue *>(this);
 }
 
-}
\ No newline at end of file
+namespace bridge {
+
+// process.binding('bridge'): profile of host's callbacks for scripts
+static void Profile(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+	auto iso = args.GetIsolate();
+	IEngine * engine = IEngine::GetEngine(iso);
+	if (!engine)
+		return;
+	auto json = v8::String::NewFromUtf8(iso, engine->ProfileJSON(), v8::NewStringType::kNormal);
+	v8::Local<v8::Value> result;
+	if (!json.IsEmpty() && v8::JSON::Parse(iso, json.ToLocalChecked()).ToLocal(&result))
+		args.GetReturnValue().Set(result);
+}
+
+static void ResetProfile(const v8::FunctionCallbackInfo<v8::Value>& args)
+{
+	IEngine * engine = IEngine::GetEngine(args.GetIsolate());
+	if (engine)
+		engine->ResetProfile();
+}
+
+static void Initialize(v8::Local<v8::Object> target, v8::Local<v8::Value> unused,
+	v8::Local<v8::Context> context)
+{
+	auto iso = context->GetIsolate();
+	target->Set(context, IEngine::InternName(iso, "profile"),
+		v8::Function::New(context, Profile).ToLocalChecked()).FromJust();
+	target->Set(context, IEngine::InternName(iso, "resetProfile"),
+		v8::Function::New(context, ResetProfile).ToLocalChecked()).FromJust();
+}
+
+}
+}
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(bridge, Bv8::bridge::Initialize)
@@ -2,20 +2,32 @@
 
 #include "v8.h"
 #include "node.h"
-#include "libplatform\libplatform.h"
+#include "libplatform/libplatform.h"
 #include <assert.h>
+#include <stdint.h>
 #include <memory>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <functional>
+#include <string>
 #include <vector>
 #include <stack>
 #include <unordered_map>
 
+// ABI of bridge: Delphi host calls virtual methods as stdcall and exported functions as cdecl.
+// Other platforms have single calling convention, so host there is native code (e.g. bridge_bench)
+#ifdef _WIN32
 #define APIENTRY __stdcall
 #define BZINTF _declspec(dllexport)
 #define BZDECL __cdecl
 #define BZDEPRECATED _declspec(deprecated)
+#else
+#define APIENTRY
+#define BZINTF __attribute__((visibility("default")))
+#define BZDECL
+#define BZDEPRECATED __attribute__((deprecated))
+#endif
 
 
 namespace Bv8 {
@@ -23,6 +35,7 @@ namespace Bv8 {
 class IObject;
 class IValueArray;
 class IRecord;
+class IRecordShape;
 class IValue;
 
 class IBazisIntf {
@@ -35,8 +48,11 @@ public:
 class IBaseValue : public IBazisIntf {
 public:
     IBaseValue(v8::Isolate * isolate, v8::Local<v8::Value> value = v8::Local<v8::Value>());
+    ~IBaseValue();
     v8::Local<v8::Value> GetV8Value();
     void SetV8Value(v8::Local<v8::Value> value);
+    //value is kept without persistent handle, so it is valid only in current HandleScope
+    void SetLocalV8Value(v8::Local<v8::Value> value);
     v8::Isolate * Isolate();
     v8::Local<v8::Context> GetCurrentContext();
     virtual bool APIENTRY IsObject();
@@ -50,6 +66,7 @@ public:
     virtual IValue * APIENTRY AsValue();
 private:
     v8::Persistent<v8::Value> v8Value;
+    v8::Local<v8::Value> localValue;
     v8::Isolate * iso;
 };
 
@@ -80,6 +97,31 @@ private:
 	IValue * returnVal = nullptr;
 };
 
+// global js function, which is resolved once and kept in persistent handle,
+// so repeated calls from host don't look it up by name
+class IPreparedCall : public IBazisIntf {
+public:
+	IPreparedCall(v8::Isolate * isolate, v8::Local<v8::Function> function);
+	~IPreparedCall();
+	// result is valid until next call
+	virtual IValue * APIENTRY Call(IValueArray * args);
+	// calls function for every item of argsBatch (item is array of one call's args) and returns
+	// array of results (valid until next call); result of failed call is undefined;
+	// returns nullptr if argsBatch is null
+	virtual IValueArray * APIENTRY CallBatch(IValueArray * argsBatch);
+	// numeric batch: args has argsPerCall numbers for every call, one number per call is written to results
+	// (NaN for failed calls); returns count of failed calls or -1 if argsPerCall or callsCount
+	// isn't positive or args/results is null
+	virtual int APIENTRY CallBatchNumbers(double * args, int argsPerCall, int callsCount, double * results);
+private:
+	v8::MaybeLocal<v8::Value> CallOnce(v8::Local<v8::Context> context, v8::Local<v8::Function> function,
+		int argc, v8::Local<v8::Value> * argv, int & errors);
+	v8::Isolate * iso = nullptr;
+	v8::Persistent<v8::Function> func;
+	std::unique_ptr<IValue> returnVal;
+	std::unique_ptr<IValueArray> returnArr;
+};
+
 class IValueArray : public IBaseValue {
 public:
 	IValueArray(v8::Isolate * isolate, v8::Local<v8::Array> values_arr);
@@ -113,10 +155,48 @@ public:
 	virtual char * APIENTRY GetStringField(char * name);
 	virtual void * APIENTRY GetObjectField(char * name);
 
+	// access by index of field in shape; record, made by NewShapedRecord, has shape already,
+	// other records (e.g. args) get it by SetShape. Out of range index is ignored
+	virtual void APIENTRY SetShape(IRecordShape * shape);
+	virtual void APIENTRY SetIntFieldAt(int index, int val);
+	virtual void APIENTRY SetDoubleFieldAt(int index, double val);
+	virtual void APIENTRY SetBoolFieldAt(int index, bool val);
+	virtual void APIENTRY SetStringFieldAt(int index, char * val);
+	virtual void APIENTRY SetValueFieldAt(int index, IBaseValue * val);
+	virtual int APIENTRY GetIntFieldAt(int index);
+	virtual double APIENTRY GetDoubleFieldAt(int index);
+	virtual bool APIENTRY GetBoolFieldAt(int index);
+	virtual char * APIENTRY GetStringFieldAt(int index);
+	//see IValue::GetArgAsUnicodeString
+	virtual int APIENTRY GetUnicodeStringField(char * name, uint16_t * buf, int len);
+
     v8::Local<v8::Object> GetV8Object();
 private:
     v8::Local<v8::Value> GetField(char * name);
+	v8::Local<v8::Value> GetFieldAt(int index);
+	void SetFieldAt(int index, v8::Local<v8::Value> val);
+	char * StringResult(v8::Local<v8::Value> val);
 	std::vector<char> run_string_result;
+	IRecordShape * shape = nullptr;
+};
+
+// Field list of records, which host makes many times (e.g. for every delphi record of
+// some type). Records are made from object template with all fields, so they share
+// V8's hidden class, and fields are accessed by interned names without lookup of strings
+class IRecordShape : public IBazisIntf {
+public:
+	IRecordShape(v8::Isolate * isolate) : iso(isolate) {};
+	// returns index of field
+	virtual int APIENTRY AddField(char * name);
+	virtual int APIENTRY FieldCount();
+
+	bool FieldName(int index, v8::Local<v8::String> * name);
+	v8::Local<v8::Object> NewInstance(v8::Local<v8::Context> context);
+private:
+	v8::Isolate * iso;
+	std::vector<v8::Eternal<v8::String>> names;
+	// made again after new field is added
+	v8::Global<v8::ObjectTemplate> templ;
 };
 
 class IValue : public IBaseValue {
@@ -143,7 +223,19 @@ public:
     virtual IRecord * APIENTRY GetArgAsRecord();
     virtual IFunction * APIENTRY GetArgAsFunction();
 
+    //callback's args are reused after callback returns, so value, which should be kept longer,
+    //has to be detached (detached value lives until engine is destroyed)
+    virtual IValue * APIENTRY Detach();
+    //gives typed array's contents without copying: data points to the first element, len is count
+    //of elements (count of bytes for TypedArrayOther). Returns kind of array (TypedArrayNone if value isn't typed array)
+    virtual int APIENTRY GetArgAsTypedArray(void ** data, size_t * len);
+    //writes up to len UTF-16 chars of value (converted to string) to buf without terminating zero;
+    //returns length of string, so it can be called with small buffer (or nullptr) first to get the size
+    //of buffer; the string, converted by that call, is taken by the next one
+    virtual int APIENTRY GetArgAsUnicodeString(uint16_t * buf, int len);
+
     int GetIndex();
+    void Reset(v8::Local<v8::Value> val, int index);
 private:
 
     IObject * GetObjectFromString();
@@ -152,12 +244,18 @@ private:
     IValueArray * arr = nullptr;
     IRecord * rec = nullptr;
     IFunction * func = nullptr;
+    std::unique_ptr<IObject> own_obj;
+    std::unique_ptr<IValueArray> own_arr;
+    std::unique_ptr<IRecord> own_rec;
+    std::unique_ptr<IFunction> own_func;
     int ind = -1;
 };
 
 class IMethodArgs : public IBazisIntf {
 public:
+	IMethodArgs();
 	IMethodArgs(const v8::FunctionCallbackInfo<v8::Value>& newArgs);
+	void Reset(const v8::FunctionCallbackInfo<v8::Value>& newArgs);
 	virtual void * APIENTRY GetEngine();
 	virtual void * APIENTRY GetDelphiObject();
 	virtual void * APIENTRY GetDelphiClasstype();
@@ -178,10 +276,17 @@ public:
 	virtual void * APIENTRY GetDelphiMethod();
 
 	virtual void APIENTRY SetError(char * errorMsg);
+	//id, which was given to IObjectTemplate::SetMethodWithId (-1 if method was registered without id)
+	virtual int APIENTRY GetMethodId();
+	//UTF-16 string of len chars (zero isn't needed)
+	virtual void APIENTRY SetReturnValueUnicode(uint16_t * val, int len);
+	//see IValue::GetArgAsUnicodeString
+	virtual int APIENTRY GetMethodNameUnicode(uint16_t * buf, int len);
 	std::string error = "";
 private:
     v8::Isolate * iso = nullptr;
 	std::vector<std::unique_ptr<IValue>> values;
+	int valuesCount = 0;
 	const v8::FunctionCallbackInfo<v8::Value>* args = nullptr;
 	std::vector<char> run_string_result;
 };
@@ -191,6 +296,14 @@ public:
 	IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop);
     IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index);
 	IGetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index);
+	IGetterArgs();
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop);
+	//name will be converted to utf8 only if host asks for it
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Name> prop);
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index);
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index);
+	//request of count elements from index for range callback
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index, int count);
 	virtual void * APIENTRY GetEngine();
 	virtual void * APIENTRY GetDelphiObject();
 	virtual void * APIENTRY GetDelphiClasstype();
@@ -210,12 +323,27 @@ public:
     virtual void APIENTRY SetGetterResult(IBaseValue * val);
 
 	virtual void APIENTRY SetError(char * errorMsg);
+	//id, which was given to IObjectTemplate::SetPropWithId/SetFieldWithId (-1 if there is no id)
+	virtual int APIENTRY GetPropId();
+	//UTF-16 string of len chars (zero isn't needed)
+	virtual void APIENTRY SetGetterResultUnicode(uint16_t * val, int len);
+	//count of elements, asked by range callback (0 for other callbacks); they start at GetPropIndex
+	virtual int APIENTRY GetRangeCount();
+	//elements from GetPropIndex as js array or typed array (it can be longer or shorter, than
+	//asked) and length of whole list (-1 if it's unknown). If range callback doesn't call it,
+	//ranges of the property are declined: its elements are got one by one
+	virtual void APIENTRY SetRangeResult(IBaseValue * values, int length);
 	std::string error = "";
+	int rangeCount = 0;
+	int rangeLength = -1;
+	v8::Local<v8::Value> rangeValues;
 private:
     v8::Isolate * iso = nullptr;
 	bool IsIndexedProp = false;
 	std::string propName = "";
+	v8::Local<v8::Name> propNameValue;
     IValue * indexValue = nullptr;
+    std::unique_ptr<IValue> own_index_value;
 	int propInd = -1;
 	const v8::PropertyCallbackInfo<v8::Value> * propinfo = nullptr;
 	std::vector<char> run_string_result;
@@ -226,6 +354,12 @@ public:
     ISetterArgs(const v8::PropertyCallbackInfo<void>& info, char * prop, v8::Local<v8::Value> newValue);
     ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index, v8::Local<v8::Value> newValue);
 	ISetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, int index, v8::Local<v8::Value> newValue);
+	ISetterArgs();
+	void Reset(const v8::PropertyCallbackInfo<void>& info, char * prop, v8::Local<v8::Value> newValue);
+	//name will be converted to utf8 only if host asks for it
+	void Reset(const v8::PropertyCallbackInfo<void>& info, v8::Local<v8::Name> prop, v8::Local<v8::Value> newValue);
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Value> index, v8::Local<v8::Value> newValue);
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, int index, v8::Local<v8::Value> newValue);
 	virtual void * APIENTRY GetEngine();
 	virtual void * APIENTRY GetDelphiObject();
 	virtual void * APIENTRY GetDelphiClasstype();
@@ -252,23 +386,34 @@ public:
     virtual void APIENTRY SetGetterResult(IBaseValue * val);
 
 	virtual void APIENTRY SetError(char * errorMsg);
+	//id, which was given to IObjectTemplate::SetPropWithId/SetFieldWithId (-1 if there is no id)
+	virtual int APIENTRY GetPropId();
+	//see IValue::GetArgAsUnicodeString
+	virtual int APIENTRY GetValueAsUnicodeString(uint16_t * buf, int len);
 	std::string error = "";
 private:
     v8::Isolate * iso = nullptr;
 	bool IsIndexedProp = false;
     IValue * indexVal = nullptr;
 	std::string propName = "";
+	v8::Local<v8::Name> propNameValue;
 	int propInd = -1;
 	std::vector<char> run_string_result;
 	const v8::PropertyCallbackInfo<void> * propinfo = nullptr;
 	const v8::PropertyCallbackInfo<v8::Value> * indexedPropInfo = nullptr;
 	v8::Local<v8::Value> newVal;
 	IValue * setterVal = nullptr;
+	std::unique_ptr<IValue> own_index_value;
+	std::unique_ptr<IValue> own_setter_value;
+	void SetNewValue(v8::Local<v8::Value> newValue);
 };
 
 class IIntfSetterArgs : public IBazisIntf {
 public:
 	IIntfSetterArgs(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop, v8::Local<v8::Value> newValue);
+	IIntfSetterArgs();
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, char * prop, v8::Local<v8::Value> newValue);
+	void Reset(const v8::PropertyCallbackInfo<v8::Value>& info, v8::Local<v8::Name> prop, v8::Local<v8::Value> newValue);
 	virtual void * APIENTRY GetEngine();
 	virtual void * APIENTRY GetDelphiObject();
 	virtual char * APIENTRY GetPropName();
@@ -285,10 +430,40 @@ public:
 private:
 	v8::Isolate * iso = nullptr;
 	std::string propName = "";
+	v8::Local<v8::Name> propNameValue;
 	std::vector<char> run_string_result;
 	const v8::PropertyCallbackInfo<v8::Value> * IntfPropInfo = nullptr;
 	v8::Local<v8::Value> newVal;
 	IValue * setterVal = nullptr;
+	std::unique_ptr<IValue> own_setter_value;
+};
+
+// Storage for callbacks' args objects, which are reused from call to call instead of
+// allocating new ones. Callbacks can be nested (js -> delphi -> js -> delphi), so every
+// nesting level gets its own object; args object is valid only until its callback returns.
+template <class T>
+class ArgsPool {
+public:
+	class Scope {
+	public:
+		template <class... Params>
+		Scope(ArgsPool<T> & argsPool, Params&&... params) : pool(argsPool) {
+			//no make_unique: header is included by node core, which is c++11
+			if (pool.depth == pool.items.size())
+				pool.items.push_back(std::unique_ptr<T>(new T()));
+			args = pool.items[pool.depth++].get();
+			args->Reset(std::forward<Params>(params)...);
+		};
+		~Scope() { pool.depth--; };
+		T * operator->() { return args; };
+		T * get() { return args; };
+	private:
+		ArgsPool<T> & pool;
+		T * args = nullptr;
+	};
+private:
+	std::vector<std::unique_ptr<T>> items;
+	size_t depth = 0;
 };
 
 typedef void(APIENTRY *TMethodCallBack) (IMethodArgs * args);
@@ -297,24 +472,143 @@ typedef void(APIENTRY *TSetterCallBack) (ISetterArgs * args);
 typedef void(APIENTRY *TIntfSetterCallBack) (IIntfSetterArgs * args);
 typedef void(APIENTRY *TErrorMsgCallBack) (const char * errMsg, void * DEngine);
 typedef void *(APIENTRY *TClassTypeChecker) (void * classType, void* dEngine);
+typedef void(APIENTRY *TObjectCollectedCallBack) (void * dObj, void * classType, void * dEngine);
+
+class IEngine;
+
+// copy of v8::HeapStatistics with fixed size fields for host
+struct HeapStats {
+	int64_t totalHeapSize;
+	int64_t totalHeapSizeExecutable;
+	int64_t totalPhysicalSize;
+	int64_t totalAvailableSize;
+	int64_t usedHeapSize;
+	int64_t heapSizeLimit;
+};
+
+// Key of js wrapper for delphi object. Same delphi object can be wrapped once per
+// class type (e.g. as object and as its property's holder), so both pointers are kept.
+struct WrapperKey {
+	void * dObj;
+	void * classType;
+	bool operator==(const WrapperKey & other) const { return dObj == other.dObj && classType == other.classType; };
+};
+
+struct WrapperKeyHash {
+	size_t operator()(const WrapperKey & key) const {
+		size_t h = std::hash<void *>()(key.dObj);
+		return h ^ (std::hash<void *>()(key.classType) + 0x9e3779b9 + (h << 6) + (h >> 2));
+	};
+};
+
+// Cached js wrapper. Handle is weak, so wrapper is evicted from cache when it is collected by GC
+struct WrapperCacheEntry {
+	WrapperKey key;
+	IEngine * engine = nullptr;
+	v8::Global<v8::Object> handle;
+};
+
+// On-disk cache of V8 code for scripts, which are run by bridge (include code and files).
+// Cache file name is hash of source and V8 version; data, rejected by V8, is removed,
+// so it is made again by next compilation
+class ICodeCache {
+public:
+	void SetDir(const char * dir);
+	bool Enabled() { return !dir.empty(); };
+	const std::string & Dir() { return dir; };
+	v8::MaybeLocal<v8::Script> Compile(v8::Local<v8::Context> context, v8::Local<v8::String> source,
+		v8::ScriptOrigin * origin, const char * sourceData, size_t sourceLength);
+	int64_t hits = 0;
+	int64_t misses = 0;
+	int64_t rejects = 0;
+	// small scripts are compiled faster, than cache is read
+	static const size_t MinSourceLength = 1024;
+private:
+	std::string FileName(const char * sourceData, size_t sourceLength);
+	std::string dir;
+};
+
+class IObjectTemplate;
 
 class IObjectProp : public IBazisIntf {
 public:
 	virtual void APIENTRY SetRead(bool Aread);;
 	virtual void APIENTRY SetWrite(bool Awrite);
 	virtual void APIENTRY setName(char * Aname);
-	IObjectProp(std::string pName, void * pObj, bool pRead = true, bool Pwrite = true);
+	IObjectProp(std::string pName, void * pObj, bool pRead = true, bool Pwrite = true, int pId = -1);
 	IObjectProp();
 	std::string name = "";
 	bool read = true;
 	bool write = true;
 	void * obj;
+	int id = -1;
+	// class, which member is registered in
+	IObjectTemplate * owner = nullptr;
 };
 
 class IObjectMethod : public IBazisIntf {
 public:
 	std::string name = "";
 	void * call = nullptr;
+	int id = -1;
+	IObjectTemplate * owner = nullptr;
+};
+
+// Statistics of host's callbacks per registered member: count of calls, total time,
+// time spent in host's callback and histogram of call times (log2 of ns). Time outside
+// of host's callback is bridge's one (arguments' objects, wrapping and exceptions).
+// Callbacks of handlers (indexed/named properties, interfaces) have no member, so they
+// are counted per kind. Profiler is off by default, as it reads clock on every call
+class IBridgeProfiler {
+public:
+	enum Kind {
+		kMethod, kGetter, kSetter, kFieldGetter, kFieldSetter, kIndexedPropObj,
+		kIndexedGetter, kIndexedSetter, kNamedGetter, kNamedSetter,
+		kInterfaceGetter, kInterfaceSetter, kInterfaceMethod, kIndexedRange, kKindCount
+	};
+
+	// measures one callback; host's call is marked by HostCall/HostDone
+	class Scope {
+	public:
+		Scope(IBridgeProfiler & profiler, Kind kind, v8::Local<v8::Value> data);
+		~Scope();
+		void HostCall();
+		void HostDone();
+	private:
+		IBridgeProfiler * profiler = nullptr;
+		Kind kind;
+		void * member = nullptr;
+		uint64_t start = 0;
+		uint64_t hostStart = 0;
+		uint64_t hostTime = 0;
+	};
+
+	bool enabled = false;
+	void Reset() { entries.clear(); };
+	// array of {class, member, kind, calls, totalNs, hostNs, bridgeNs, maxNs, p50Ns, p90Ns, p99Ns}
+	std::string ToJSON();
+private:
+	static const int kBuckets = 40;
+	struct Key {
+		void * member;
+		Kind kind;
+		bool operator==(const Key & other) const { return member == other.member && kind == other.kind; };
+	};
+	struct KeyHash {
+		size_t operator()(const Key & key) const {
+			return std::hash<void *>()(key.member) ^ (size_t(key.kind) * 0x9e3779b9);
+		};
+	};
+	struct Entry {
+		int64_t calls = 0;
+		uint64_t totalNs = 0;
+		uint64_t hostNs = 0;
+		uint64_t maxNs = 0;
+		int64_t buckets[kBuckets] = {};
+	};
+	void Record(void * member, Kind kind, uint64_t time, uint64_t hostTime);
+	static uint64_t Percentile(const Entry & entry, double p);
+	std::unordered_map<Key, Entry, KeyHash> entries;
 };
 
 class IDelphiEnumValue {
@@ -336,14 +630,21 @@ public:
 	virtual void APIENTRY SetEnumField(char * valuename, int value);
 	virtual void APIENTRY SetHasIndexedProps(bool hasIndProps);
 	virtual void APIENTRY SetParent(IObjectTemplate * parent);
+	// id is returned to host by IMethodArgs::GetMethodId, IGetterArgs::GetPropId and ISetterArgs::GetPropId,
+	// so host can find called member by index instead of its name
+	virtual void APIENTRY SetMethodWithId(char * methodName, void * methodCall, int id);
+	virtual void APIENTRY SetPropWithId(char* propName, void * propObj, bool read, bool write, int id);
+	virtual void APIENTRY SetFieldWithId(char* fieldName, int id);
 
 	void * DClass = nullptr;
     std::string classTypeName;
 
 	v8::Local<v8::FunctionTemplate> objTempl;
+	// template of registered parent class, objTempl inherits its template
+	IObjectTemplate * parent = nullptr;
 	std::vector<std::unique_ptr<IObjectProp>> props;
 	std::vector<std::unique_ptr<IObjectProp>> ind_props;
-	std::vector<std::string> fields;
+	std::vector<std::unique_ptr<IObjectProp>> fields;
 	std::vector<std::unique_ptr<IObjectMethod>> methods;
 	std::vector<std::unique_ptr<IDelphiEnumValue>> enums;
 
@@ -358,7 +659,8 @@ private:
 class IEngine : public IBazisIntf {
 public:
 	~IEngine();
-	IEngine(void * DEngine);
+	IEngine(void * DEngine, const char * snapshot = nullptr, int snapshotSize = 0,
+		int maxOldSpaceMb = 0, int maxSemiSpaceMb = 0);
 
 	//std::stack<std::unique_ptr<v8::Isolate>> isolates;
 	v8::Isolate * isolate = nullptr;
@@ -382,9 +684,12 @@ public:
 
 	virtual void APIENTRY SetDebug(bool debug, char * arg);
 	bool DebugMode();
+	bool WarmRun();
 	virtual int APIENTRY ErrorCode();
 	void SetErrorCode(int code);
 	void ExecIncludeCode(v8::Local<v8::Context> context);
+	// called by node before bootstrap
+	void SetupProcessObject(v8::Local<v8::Object> process);
 
 	virtual void APIENTRY SetMethodCallBack(TMethodCallBack callBack);
 	virtual void APIENTRY SetPropGetterCallBack(TGetterCallBack callBack);
@@ -411,6 +716,76 @@ public:
 	virtual IObject * APIENTRY NewObject(void * value, void * classtype);
     virtual IValue * APIENTRY NewInterfaceObject(void * value);
 
+	// called when js wrapper of delphi object is collected by GC;
+	// it is called from GC, so host mustn't call into engine from this callback
+	virtual void APIENTRY SetObjectCollectedCallBack(TObjectCollectedCallBack callBack);
+	// wrapper cache statistics
+	virtual int APIENTRY WrapperCacheSize();
+	virtual int64_t APIENTRY WrapperCacheHits();
+	virtual int64_t APIENTRY WrapperCacheMisses();
+	virtual int64_t APIENTRY WrapperCacheEvictions();
+	// typed arrays over host's numeric arrays. If copy is false, array uses host's memory
+	// directly, so memory has to live while script can reach the array
+	virtual IValue * APIENTRY NewFloat64Array(void * data, size_t len, bool copy);
+	virtual IValue * APIENTRY NewInt32Array(void * data, size_t len, bool copy);
+	// returns nullptr, if there is no global function with such name;
+	// prepared call lives until engine is destroyed
+	virtual IPreparedCall * APIENTRY PrepareCall(char * funcName);
+	// values, made by engine for host (New* values, CallFunc results, detached values) after
+	// BeginValueScope, are deleted by matching EndValueScope; scopes can be nested
+	virtual void APIENTRY BeginValueScope();
+	virtual void APIENTRY EndValueScope();
+	// count of values, kept by engine
+	virtual int APIENTRY ValueCount();
+	// in warm run mode RunString/RunFile reuse environment, started by previous run:
+	// node isn't bootstrapped again and required modules stay cached; additional params
+	// are taken only by the first (cold) run. Debug mode always runs cold
+	virtual void APIENTRY SetWarmRun(bool warm);
+	// directory of code cache for include code, include files and modules (empty dir disables it);
+	// statistics include modules, compiled by js side of cache
+	virtual void APIENTRY SetCodeCacheDir(char * dir);
+	virtual int64_t APIENTRY CodeCacheHits();
+	virtual int64_t APIENTRY CodeCacheMisses();
+	virtual int64_t APIENTRY CodeCacheRejects();
+	// directory of TypeScript transpilation cache (output is cached in memory anyway)
+	virtual void APIENTRY SetTranspileCacheDir(char * dir);
+	// count of threads, which transpile .ts module graph of main module before it is run
+	// (0 turns prefetch off; -1 means count of processors)
+	virtual void APIENTRY SetTranspileThreads(int threads);
+	// in step mode RunString/RunFile return right after script's first tick (error code stays -1
+	// until script calls process.exit), and host runs the rest of it by RunFor/PumpOnce
+	virtual void APIENTRY SetStepMode(bool step);
+	// runs timers, i/o and microtasks of started script for ms at most without waiting beyond it;
+	// result: 1 - script has more work, 0 - it is finished, -1 - no script is started
+	virtual int APIENTRY RunFor(int ms);
+	// runs callbacks, which are ready now, without waiting; result is the same as RunFor's one
+	virtual int APIENTRY PumpOnce();
+	// wall time and cpu time limits (ms, 0 - no limit) of every RunString/RunFile/RunFor/PumpOnce;
+	// script, which is over one of them, is interrupted
+	virtual void APIENTRY SetRunLimits(int wallMs, int cpuMs);
+	// terminates running script and stops its event loop; it's the only method,
+	// which can be called from other thread. Error code of interrupted script is kInterruptedErrCode
+	virtual void APIENTRY Interrupt();
+	virtual void APIENTRY GetHeapStatistics(HeapStats * stats);
+	// full gc, which frees as much as possible (e.g. when host is short of memory)
+	virtual void APIENTRY LowMemoryNotification();
+	// shape, registered for host's key (e.g. type info of delphi record); new shape is empty
+	// and host adds fields to it. Shapes live as long as engine
+	virtual IRecordShape * APIENTRY RecordShape(void * key);
+	virtual IRecord * APIENTRY NewShapedRecord(IRecordShape * shape);
+	// string from host's UTF-16 chars (len without zero); large strings are kept out of V8's heap
+	virtual IValue * APIENTRY NewUnicodeString(uint16_t * value, int len);
+	// profiler of host's callbacks (see IBridgeProfiler); it's also got by scripts
+	// as process.binding('bridge').profile(). Json lives until next ProfileJSON call
+	virtual void APIENTRY SetProfiling(bool enabled);
+	virtual char * APIENTRY ProfileJSON();
+	virtual void APIENTRY ResetProfile();
+	// host's callback, which gives ranges of elements of indexed properties (see IGetterArgs::GetRangeCount).
+	// Elements, got by range, and length of list are cached by js object of property, so loops over list
+	// don't call host for every element. Cache is valid until host's code can change lists: until
+	// any host's method or setter is called or host calls engine (run, call, step)
+	virtual void APIENTRY SetIndexedPropRangeCallBack(TGetterCallBack callBack);
+
 
 	void * globObject = nullptr;
 	IObjectTemplate * globalTemplate = nullptr;
@@ -423,7 +798,34 @@ public:
 	v8::Local<v8::Object> FindObject(void * dObj, void * classType, v8::Isolate * iso);
 	void AddObject(void * dObj, void * classType, v8::Local<v8::Object> obj, v8::Isolate * iso);
 
+	v8::Local<v8::ArrayBuffer> NewArrayBuffer(void * data, size_t byteLength, bool copy);
+
 	void LogErrorMessage(const char * msg);
+	// internalized string for host's name (member, field or function name). Names are kept
+	// for isolate's life (up to kMaxInternedNames), so repeated ones aren't allocated and
+	// hashed again. Engine of isolate is used, if there is one
+	v8::Local<v8::String> InternName(const char * name);
+	static v8::Local<v8::String> InternName(v8::Isolate * iso, const char * name);
+	// epoch of state, which is shared by scripts and host. It is bumped, whenever js can run or
+	// host can change its objects behind wrappers: by runs, host's calls of js functions and
+	// callbacks, conversions of objects (their toString()) and after host's setters. Caches
+	// (ranges of indexed properties, converted strings of KeepUnicodeConversion) are valid
+	// only in epoch, in which they were made
+	void BumpScriptEpoch() { scriptEpoch++; };
+	// string of value, converted for host, which took only its length (or a part); host's next
+	// call for the same value takes it, so toString() isn't run twice (see BumpScriptEpoch)
+	void KeepUnicodeConversion(v8::Local<v8::Value> val, v8::Local<v8::String> str);
+	bool TakeUnicodeConversion(v8::Local<v8::Value> val, v8::Local<v8::String> * str);
+	//makes IValue, which lives until the end of current value scope (or until engine is destroyed);
+	//detached value isn't bound to value scope
+	IValue * KeepValue(v8::Local<v8::Value> value);
+	IValue * KeepDetachedValue(v8::Local<v8::Value> value);
+	template <class T>
+	T * Keep(std::unique_ptr<T> value) {
+		auto result = value.get();
+		IValues.push_back({ std::move(value), Poolable(result) });
+		return result;
+	};
 
 	v8::Local<v8::ObjectTemplate> MakeGlobalTemplate(v8::Isolate * iso);
 	//will be initialized at MakeGlobalTemplate method.
@@ -437,14 +839,50 @@ public:
 private:
 	std::vector<char> run_string_result;
 	std::string include_code;
-	std::vector<std::unique_ptr<IBazisIntf>> IValues;
+	//value of scope; pooled is set for IValue, which is reused after the end of scope
+	struct KeptValue {
+		std::unique_ptr<IBazisIntf> value;
+		IValue * pooled;
+	};
+	static IValue * Poolable(IValue * value) { return value; };
+	static IValue * Poolable(IBazisIntf * value) { return nullptr; };
+	std::vector<KeptValue> IValues;
+	std::vector<std::unique_ptr<IPreparedCall>> preparedCalls;
+	std::unordered_map<void *, std::unique_ptr<IRecordShape>> recordShapes;
+	std::vector<std::unique_ptr<IValue>> detachedValues;
+	// IValues' sizes at BeginValueScope calls
+	std::vector<size_t> valueScopes;
+	// released IValue objects for reuse
+	std::vector<std::unique_ptr<IValue>> freeValues;
+	static const size_t MaxFreeValues = 1024;
 	node::NodeEngine * node_engine;
+	bool warmRun = false;
+	ICodeCache codeCache;
+	std::string transpileCacheDir;
+	int transpileThreads = 0;
+	int64_t ModuleCodeCacheStat(const char * name);
+
+	std::unordered_map<WrapperKey, std::unique_ptr<WrapperCacheEntry>, WrapperKeyHash> JSObjects;
+	int64_t wrapperHits = 0;
+	int64_t wrapperMisses = 0;
+	int64_t wrapperEvictions = 0;
+
+	IBridgeProfiler profiler;
+	std::string profileJSON;
+
+	std::unordered_map<std::string, v8::Eternal<v8::String>> internedNames;
+	static const size_t kMaxInternedNames = 4096;
+
+	// host is told (by error message callback), when heap after gc takes kNearHeapLimit
+	// of its limit; if limits were set by host, script is interrupted too, as V8 aborts
+	// the process on heap exhaustion. Message is repeated after heap falls below kHeapLimitReset
+	static void HeapLimitCheck(v8::Isolate * iso, v8::GCType type, v8::GCCallbackFlags flags);
+	static constexpr double kNearHeapLimit = 0.9;
+	static constexpr double kHeapLimitReset = 0.8;
+	bool heapLimitsSet = false;
+	bool nearHeapLimit = false;
+	static void WrapperCollected(const v8::WeakCallbackInfo<WrapperCacheEntry>& info);
 
-	std::unordered_map<int64_t, v8::Persistent<v8::Object, v8::CopyablePersistentTraits<v8::Object>> > JSObjects;
-
-	std::unique_ptr<IValueArray> run_result_array;
-	std::unique_ptr<IValue> run_result_value;
-    std::unique_ptr<IObject> run_result_object;
 
 	TMethodCallBack methodCall;
 	TGetterCallBack getterCall;
@@ -454,6 +892,7 @@ private:
 	TGetterCallBack IndPropGetterObjCall;
 	TGetterCallBack IndPropGetterCall;
 	TSetterCallBack IndPropSetterCall;
+	TGetterCallBack IndPropRangeCall = nullptr;
     TGetterCallBack NamedPropGetterCall;
     TSetterCallBack NamedPropSetterCall;
 	TGetterCallBack IFaceGetterPropCall;
@@ -461,9 +900,11 @@ private:
 	TMethodCallBack IFaceMethodCall;
 	TErrorMsgCallBack ErrMsgCallBack;
 	TClassTypeChecker CheckClassType;
+	TObjectCollectedCallBack ObjectCollectedCallBack = nullptr;
 	bool debugMode = false;
     char * debugArg = nullptr;
 	int errCode = 0;
+	static const int kInterruptedErrCode = 1001;
 	IValue * func_result;
 
 	std::vector<std::unique_ptr<IObjectTemplate>> objects;
@@ -471,6 +912,25 @@ private:
 	std::vector<std::string> fields;
 	std::vector<v8::Local<v8::ObjectTemplate>> v8Templates;
 
+	ArgsPool<IMethodArgs> methodArgsPool;
+	ArgsPool<IGetterArgs> getterArgsPool;
+	ArgsPool<ISetterArgs> setterArgsPool;
+	ArgsPool<IIntfSetterArgs> intfSetterArgsPool;
+
+	// see BumpScriptEpoch; range cache of indexed object is
+	// [epoch, start, length, values, size of next range]
+	double scriptEpoch = 0;
+	// see KeepUnicodeConversion
+	v8::Global<v8::Value> unicodeSource;
+	v8::Global<v8::String> unicodeString;
+	double unicodeEpoch = 0;
+	static const uint32_t kIndexedRangeMin = 256;
+	static const uint32_t kIndexedRangeMax = 65536;
+	v8::Local<v8::Array> IndexedRange(const v8::PropertyCallbackInfo<v8::Value>& info, int64_t index);
+	bool IndexedCacheGet(const v8::PropertyCallbackInfo<v8::Value>& info, uint32_t index, v8::Local<v8::Value> & value);
+	bool IndexedCacheLength(const v8::PropertyCallbackInfo<v8::Value>& info, int & length);
+	void IndexedCacheSet(const v8::PropertyCallbackInfo<v8::Value>& info, uint32_t index, double epoch);
+
 	static void IndexedPropObjGetter(v8::Local<v8::String> property,
 		const v8::PropertyCallbackInfo<v8::Value>& info);
 	static void IndexedPropGetter(unsigned int index, const v8::PropertyCallbackInfo<v8::Value>& info);
@@ -508,8 +968,18 @@ const int DelphiObjectIndex = 0;
 const int DelphiClassTypeIndex = 1;
 
 const int ObjectInternalFieldCount = 2;
+//objects of indexed properties (and objects of classes with default indexed property)
+//have one more field for cached range of elements
+const int IndexedCacheIndex = 2;
 // Object internal fields' consts-->>
 
+// <<--kinds of typed arrays, returned by IValue::GetArgAsTypedArray
+const int TypedArrayNone = 0;
+const int TypedArrayFloat64 = 1;
+const int TypedArrayInt32 = 2;
+const int TypedArrayOther = 3;
+// kinds of typed arrays-->>
+
 namespace Bazis {
 extern "C" {
     BZINTF int BZDECL GetMajorVersion();
@@ -519,6 +989,17 @@ extern "C" {
 
 	BZINTF IEngine* BZDECL InitGlobalEngine(void * DEngine);
 
+	// startup snapshot with result of running plain js source (e.g. host's include libraries),
+	// warmupSource (optional) is compiled into snapshot too. Returns nullptr on failure;
+	// data has to be released by FreeStartupSnapshot
+	BZINTF char* BZDECL CreateStartupSnapshot(char * source, char * warmupSource, int * size);
+	BZINTF void BZDECL FreeStartupSnapshot(char * data);
+	// engine's isolate is made from snapshot, data can be released after the call
+	BZINTF IEngine* BZDECL InitEngineWithSnapshot(void * DEngine, char * snapshot, int size);
+	// engine with heap limits in MB (0 keeps V8's default), snapshot is optional
+	BZINTF IEngine* BZDECL InitEngineWithHeapLimits(void * DEngine, char * snapshot, int size,
+		int maxOldSpaceMb, int maxSemiSpaceMb);
+
     BZINTF void BZDECL InitializeNode();
 
 	BZINTF void BZDECL FinalizeNode();
@@ -7,6 +7,7 @@
 #include "node_version.h"
 #include "node_internals.h"
 #include "node_revert.h"
+#include "node_watchdog.h"
 #include "delphi_intf.h"
 
 #if defined HAVE_PERFCTR
@@ -95,6 +96,14 @@ typedef int mode_t;
 extern char **environ;
 #endif
 
+// failures of engine reach delphi bridge as node::V8Exception. Outside msvc
+// node core is built without exceptions (see node.gyp), there they abort
+#if defined(_MSC_VER) || defined(__cpp_exceptions)
+#define THROW_V8_EXCEPTION() throw node::V8Exception()
+#else
+#define THROW_V8_EXCEPTION() ABORT_NO_BACKTRACE()
+#endif
+
 namespace node {
 
 using v8::Array;
@@ -124,6 +133,7 @@ using v8::PromiseRejectMessage;
 using v8::PropertyCallbackInfo;
 using v8::ScriptOrigin;
 using v8::SealHandleScope;
+using v8::StartupData;
 using v8::String;
 using v8::TryCatch;
 using v8::Uint32;
@@ -131,32 +141,36 @@ using v8::Uint32Array;
 using v8::V8;
 using v8::Value;
 
-static bool print_eval = false;
-static bool force_repl = false;
-static bool syntax_check_only = false;
-static bool trace_deprecation = false;
-static bool throw_deprecation = false;
-static bool trace_sync_io = false;
-static bool track_heap_objects = false;
-static const char* eval_string = nullptr;
-static const char * filename_string = nullptr;
-static unsigned int preload_module_count = 0;
-static const char** preload_modules = nullptr;
+// Options of script run are set by ParseArgs for every RunScript and are read
+// while its environment starts. Engines are bound to the thread, which locks
+// their isolate, so these options are kept per thread: engines, which run on
+// different threads, don't see each other's options.
+static thread_local bool print_eval = false;
+static thread_local bool force_repl = false;
+static thread_local bool syntax_check_only = false;
+static thread_local bool trace_deprecation = false;
+static thread_local bool throw_deprecation = false;
+static thread_local bool trace_sync_io = false;
+static thread_local bool track_heap_objects = false;
+static thread_local const char* eval_string = nullptr;
+static thread_local const char * filename_string = nullptr;
+static thread_local unsigned int preload_module_count = 0;
+static thread_local const char** preload_modules = nullptr;
 #if HAVE_INSPECTOR
-static bool use_inspector = false;
+static thread_local bool use_inspector = false;
 #else
 static const bool use_inspector = false;
 #endif
-static bool use_debug_agent = false;
-static bool debug_wait_connect = false;
-static std::string debug_host;  // NOLINT(runtime/string)
-static int debug_port = 5858;
-static std::string inspector_host;  // NOLINT(runtime/string)
-static int inspector_port = 9229;
+static thread_local bool use_debug_agent = false;
+static thread_local bool debug_wait_connect = false;
+static thread_local std::string debug_host;  // NOLINT(runtime/string)
+static thread_local int debug_port = 5858;
+static thread_local std::string inspector_host;  // NOLINT(runtime/string)
+static thread_local int inspector_port = 9229;
 static const int v8_default_thread_pool_size = 4;
 static int v8_thread_pool_size = v8_default_thread_pool_size;
-static bool prof_process = false;
-static bool v8_is_profiling = false;
+static thread_local bool prof_process = false;
+static thread_local bool v8_is_profiling = false;
 static bool node_is_initialized = false;
 static node_module* modpending;
 static node_module* modlist_builtin;
@@ -1762,7 +1776,7 @@ void GetActiveHandles(const FunctionCallbackInfo<Value>& args) {
 NO_RETURN void Abort() {
   DumpBacktrace(stderr);
   fflush(stderr);
-  throw(V8Exception());
+  THROW_V8_EXCEPTION();
   /// NODE: ABORT_NO_BACKTRACE();
 }
 
@@ -4424,13 +4438,59 @@ private:
 };
 
 NodeEngine::NodeEngine()
+{
+	CreateIsolate();
+}
+
+NodeEngine::NodeEngine(const char * snapshot_data, int snapshot_size,
+	int max_old_space_mb, int max_semi_space_mb) : max_old_space(max_old_space_mb),
+	max_semi_space(max_semi_space_mb)
+{
+	if (snapshot_data && snapshot_size > 0) {
+		auto data = new char[snapshot_size];
+		memcpy(data, snapshot_data, snapshot_size);
+		snapshot_blob.data = data;
+		snapshot_blob.raw_size = snapshot_size;
+	}
+	CreateIsolate();
+}
+
+//isolate's data slot with its NodeEngine (slot 0 is host's engine, see
+//delphi_intf.h, NODE_ISOLATE_SLOT is node's IsolateData)
+static const uint32_t kNodeEngineSlot = 1;
+
+void exit(int code) {
+	Isolate * isolate = Isolate::GetCurrent();
+	NodeEngine * engine = nullptr;
+	if (isolate)
+		engine = static_cast<NodeEngine *>(isolate->GetData(kNodeEngineSlot));
+	if (engine && engine->exit_callback)
+		engine->exit_callback(code);
+	else
+		::exit(code);
+}
+
+void NodeEngine::CreateIsolate()
 {
 	node_started = false;
 	Isolate::CreateParams params;
     array_buffer_allocator = new ArrayBufferAllocator();
 	params.array_buffer_allocator = static_cast<ArrayBufferAllocator *>(array_buffer_allocator);
+	if (snapshot_blob.data)
+		params.snapshot_blob = &snapshot_blob;
+	if (max_old_space > 0)
+		params.constraints.set_max_old_space_size(max_old_space);
+	if (max_semi_space > 0)
+		params.constraints.set_max_semi_space_size(max_semi_space);
 	node_engine_isolate = Isolate::New(params);
+	node_engine_isolate->SetData(kNodeEngineSlot, this);
 	script_params_ptr = new ScriptParams(node_engine_isolate);
+	event_loop = new uv_loop_t;
+	CHECK_EQ(0, uv_loop_init(event_loop));
+	interrupt_async = new uv_async_t;
+	CHECK_EQ(0, uv_async_init(event_loop, interrupt_async, [](uv_async_t *) {}));
+	//it mustn't keep script's loop alive
+	uv_unref(reinterpret_cast<uv_handle_t *>(interrupt_async));
 }
 
 NodeEngine::~NodeEngine()
@@ -4439,14 +4499,141 @@ NodeEngine::~NodeEngine()
 	//it should be there, but now it throws an exception
 	delete static_cast<ScriptParams *>(script_params_ptr);
 	node_engine_isolate->Dispose();
+	delete[] snapshot_blob.data;
+	uv_close(reinterpret_cast<uv_handle_t *>(interrupt_async),
+		[](uv_handle_t * handle) { delete reinterpret_cast<uv_async_t *>(handle); });
+	uv_run(event_loop, UV_RUN_NOWAIT);
+	//loop can't be closed while script's handles are alive, it is left then
+	if (uv_loop_close(event_loop) == 0)
+		delete event_loop;
 }
 
 //static v8::Isolate * node_engine_isolate;
 
+//one iteration of event loop; returns false when loop is drained (after 'beforeExit')
+//or script is interrupted
+static bool StepEventLoop(NodeEngine * engine, Environment * env, uv_run_mode mode) {
+	Isolate * isolate = engine->node_engine_isolate;
+	if (engine->WasInterrupted())
+		return false;
+	SealHandleScope seal(isolate);
+	v8_platform.PumpMessageLoop(isolate);
+	bool more = uv_run(env->event_loop(), mode) != 0;
+	if (engine->WasInterrupted())
+		return false;
+
+	if (more == false) {
+		v8_platform.PumpMessageLoop(isolate);
+		EmitBeforeExit(env);
+
+		// Emit `beforeExit` if the loop became alive either after emitting
+		// event, or after running some callbacks.
+		more = uv_loop_alive(env->event_loop()) != 0;
+		if (uv_run(env->event_loop(), UV_RUN_NOWAIT) != 0)
+			more = true;
+	}
+	return more;
+}
+
+static void SpinEventLoop(NodeEngine * engine, Environment * env) {
+	while (StepEventLoop(engine, env, UV_RUN_ONCE)) {
+	}
+}
+
+//cpu time of calling thread in ns
+static uint64_t ThreadCpuTime() {
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+		return 0;
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernel_time.dwLowDateTime;
+	kernel.HighPart = kernel_time.dwHighDateTime;
+	user.LowPart = user_time.dwLowDateTime;
+	user.HighPart = user_time.dwHighDateTime;
+	//100 ns units
+	return (kernel.QuadPart + user.QuadPart) * 100;
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0;
+	return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+//limits of one call, which runs script (see NodeEngine::SetRunLimits).
+//Wall time is checked by watchdog's thread. Cpu time of engine's thread can be taken
+//only by that thread, so watchdog requests interrupt, where engine checks it itself
+class RunLimitScope {
+public:
+	explicit RunLimitScope(NodeEngine * engine) : engine_(engine) {
+		if (engine->run_wall_limit == 0 && engine->run_cpu_limit == 0)
+			return;
+		start_ = uv_hrtime();
+		engine->run_cpu_start = ThreadCpuTime();
+		engine->run_limits_active = true;
+		watchdog_.reset(new Watchdog(engine->node_engine_isolate, kCheckInterval, Check, this));
+	}
+	~RunLimitScope() {
+		//joins watchdog's thread
+		watchdog_.reset();
+		engine_->run_limits_active = false;
+	}
+private:
+	static const uint64_t kCheckInterval = 10;
+
+	//on watchdog's thread; true stops watchdog
+	static bool Check(void * data) {
+		RunLimitScope * scope = static_cast<RunLimitScope *>(data);
+		NodeEngine * engine = scope->engine_;
+		if (engine->run_wall_limit > 0 &&
+			(uv_hrtime() - scope->start_) / 1000000 >= engine->run_wall_limit) {
+			engine->Interrupt();
+			return true;
+		}
+		//interrupt is served, when js runs; while engine waits for events, cpu isn't spent
+		if (engine->run_cpu_limit > 0 && !engine->cpu_check_pending.exchange(true))
+			engine->node_engine_isolate->RequestInterrupt(CheckCpu, engine);
+		return false;
+	}
+
+	//on engine's thread; request can be served after scope is left, so data is engine
+	static void CheckCpu(Isolate * isolate, void * data) {
+		NodeEngine * engine = static_cast<NodeEngine *>(data);
+		engine->cpu_check_pending = false;
+		if (engine->run_limits_active && engine->run_cpu_limit > 0 &&
+			(ThreadCpuTime() - engine->run_cpu_start) / 1000000 >= engine->run_cpu_limit)
+			engine->Interrupt();
+	}
+
+	NodeEngine * engine_;
+	uint64_t start_ = 0;
+	std::unique_ptr<Watchdog> watchdog_;
+};
+
+//run of js or event loop, which Interrupt can target. Termination, requested by Interrupt
+//when run is about to return, isn't served by js and would be left pending: later calls
+//of engine (CallFunc, prepared calls) would fail then, so it's cancelled here
+class RunScope {
+public:
+	explicit RunScope(NodeEngine * engine) : engine_(engine) {
+		std::lock_guard<std::mutex> lock(engine->interrupt_mutex);
+		engine->running = true;
+	}
+	~RunScope() {
+		std::lock_guard<std::mutex> lock(engine_->interrupt_mutex);
+		engine_->running = false;
+		if (engine_->interrupted)
+			engine_->node_engine_isolate->CancelTerminateExecution();
+	}
+private:
+	NodeEngine * engine_;
+};
+
 void NodeEngine::StartNodeInstance(void* arg, void* eng) {
   using namespace Bv8;
   if (!node_engine_isolate) {
-	  throw V8Exception();
+	  THROW_V8_EXCEPTION();
   }
   NodeInstanceData* instance_data = static_cast<NodeInstanceData*>(arg);
   {
@@ -4485,6 +4672,8 @@ void NodeEngine::StartNodeInstance(void* arg, void* eng) {
     instance_data->exec_argc(),
     instance_data->exec_argv(),
     v8_is_profiling);
+  if (eng)
+    static_cast<IEngine *>(eng)->SetupProcessObject(env->process_object());
 
   node_started = true;
   if (!wasInitialized) {
@@ -4511,25 +4700,9 @@ void NodeEngine::StartNodeInstance(void* arg, void* eng) {
     engine->ExecIncludeCode(context);
   }
 
-  {
-	SealHandleScope seal(node_engine_isolate);
-	bool more;
-	do {
-		v8_platform.PumpMessageLoop(node_engine_isolate);
-		more = uv_run(env->event_loop(), UV_RUN_ONCE);
-
-		if (more == false) {
-			v8_platform.PumpMessageLoop(node_engine_isolate);
-			EmitBeforeExit(env);
-
-			// Emit `beforeExit` if the loop became alive either after emitting
-			// event, or after running some callbacks.
-			more = uv_loop_alive(env->event_loop());
-			if (uv_run(env->event_loop(), UV_RUN_NOWAIT) != 0)
-				more = true;
-		}
-	} while (more == true);
-  }
+  //in step mode host runs the loop by RunFor/PumpOnce
+  if (!step_mode)
+    SpinEventLoop(this, env);
 }
 
 void NodeEngine::StopNodeInstance() {
@@ -4586,12 +4759,11 @@ void NodeEngine::StopNodeInstance() {
     v8_thread_pool_size = v8_default_thread_pool_size;
     prof_process = false;
     v8_is_profiling = false;
-    node_is_initialized = false;
 
 }
 
 int NodeEngine::Start(int argc, char** argv, std::function<void(int)> func, void* eng) {
-	exit = func;
+	exit_callback = func;
   PlatformInit();
 
   CHECK_GT(argc, 0);
@@ -4622,7 +4794,7 @@ int NodeEngine::Start(int argc, char** argv, std::function<void(int)> func, void
   int exit_code = 1;
   {
     NodeInstanceData instance_data(NodeInstanceType::WORKER,
-                                   uv_default_loop(),
+                                   event_loop,
                                    argc,
                                    const_cast<const char**>(argv),
                                    exec_argc,
@@ -4639,8 +4811,8 @@ int NodeEngine::Start(int argc, char** argv, std::function<void(int)> func, void
 }
 
 /// node rerun methods
-int exec_argc_ = 0;
-const char** exec_argv_ = nullptr;
+thread_local int exec_argc_ = 0;
+thread_local const char** exec_argv_ = nullptr;
 
 void InitIalize(int argc, char *argv[]) {
 	PlatformInit();
@@ -4674,7 +4846,12 @@ static bool scripts_running;
 NODE_EXTERN int NodeEngine::RunScript(int argc, char * argv[], std::function<void(int)> func, void * eng)
 {
 	StopNodeInstance();
-	exit = func;
+	//termination, requested by Interrupt, can be left pending, if no js was run after it
+	if (interrupted) {
+		interrupted = false;
+		node_engine_isolate->CancelTerminateExecution();
+	}
+	exit_callback = func;
 	int exit_code = 0;
 
 	int v8_argc;
@@ -4687,15 +4864,21 @@ NODE_EXTERN int NodeEngine::RunScript(int argc, char * argv[], std::function<voi
 		instance_type = NodeInstanceType::MAIN;
 	else
 		instance_type = NodeInstanceType::WORKER;
-	ParseArgs(&argc, const_cast<const char**>(argv), &exec_argc_, &exec_argv_, &v8_argc, &v8_argv);
+	{
+		//exit of ParseArgs (bad option, --version) goes to this engine's callback
+		Isolate::Scope iso_scope(node_engine_isolate);
+		ParseArgs(&argc, const_cast<const char**>(argv), &exec_argc_, &exec_argv_, &v8_argc, &v8_argv);
+	}
 	{
 		NodeInstanceData instance_data(instance_type,
-			uv_default_loop(),
+			event_loop,
 			argc,
 			const_cast<const char**>(argv),
 			exec_argc_,
 			exec_argv_,
 			use_debug_agent);
+		RunLimitScope limits(this);
+		RunScope run(this);
 		StartNodeInstance(&instance_data, eng);
 		/*if (instance_type == NodeInstanceType::MAIN)
 			exit_code = instance_data.exit_code();*/
@@ -4703,6 +4886,98 @@ NODE_EXTERN int NodeEngine::RunScript(int argc, char * argv[], std::function<voi
 	return exit_code;
 }
 
+NODE_EXTERN int NodeEngine::RunScriptWarm(const char * name, const char * code, bool isFile, std::function<void(int)> func, void * eng)
+{
+	//state of interrupted script is unknown, so it's run cold
+	if (!node_started || interrupted)
+		return -1;
+	RunLimitScope limits(this);
+	RunScope run(this);
+	Isolate::Scope iso_scope(node_engine_isolate);
+	HandleScope handle_scope(node_engine_isolate);
+	Environment * env = static_cast<EnvWrapeer *>(env_wrapper_ptr)->GetEnvironment();
+	auto context = env->context();
+	Local<Object> process = env->process_object();
+	//installed by bootstrap_node.js
+	Local<Value> run_v;
+	if (!process->Get(context, FIXED_ONE_BYTE_STRING(node_engine_isolate, "_runWarmScript")).ToLocal(&run_v) ||
+		!run_v->IsFunction())
+		return -1;
+	exit_callback = func;
+
+	Local<Value> args[] = {
+		String::NewFromUtf8(node_engine_isolate, name),
+		code ? String::NewFromUtf8(node_engine_isolate, code).As<Value>() : Undefined(node_engine_isolate).As<Value>(),
+		Boolean::New(node_engine_isolate, isFile)
+	};
+	//uncaught exception of entry script goes to process' 'uncaughtException' as usual
+	MakeCallback(env, process.As<Value>(), run_v.As<Function>(), arraysize(args), args);
+	if (!step_mode)
+		SpinEventLoop(this, env);
+	return 0;
+}
+
+NODE_EXTERN int NodeEngine::RunFor(unsigned int ms)
+{
+	if (!node_started)
+		return -1;
+	if (interrupted)
+		return 0;
+	RunLimitScope limits(this);
+	RunScope run(this);
+	Isolate::Scope iso_scope(node_engine_isolate);
+	Environment * env = static_cast<EnvWrapeer *>(env_wrapper_ptr)->GetEnvironment();
+	const uint64_t start = uv_hrtime();
+	const uint64_t budget = uint64_t(ms) * 1000000;
+	bool more = true;
+	while (more) {
+		uint64_t elapsed = uv_hrtime() - start;
+		if (elapsed >= budget)
+			break;
+		uint64_t left_ms = (budget - elapsed) / 1000000;
+		int wait = uv_backend_timeout(env->event_loop());
+		//nothing is expected in the rest of budget (next timer is later or loop waits for i/o),
+		//so ready callbacks are run without blocking and control goes back to host
+		if (wait < 0 || uint64_t(wait) > left_ms) {
+			more = StepEventLoop(this, env, UV_RUN_NOWAIT);
+			break;
+		}
+		more = StepEventLoop(this, env, UV_RUN_ONCE);
+	}
+	return more ? 1 : 0;
+}
+
+NODE_EXTERN int NodeEngine::PumpOnce()
+{
+	if (!node_started)
+		return -1;
+	if (interrupted)
+		return 0;
+	RunLimitScope limits(this);
+	RunScope run(this);
+	Isolate::Scope iso_scope(node_engine_isolate);
+	Environment * env = static_cast<EnvWrapeer *>(env_wrapper_ptr)->GetEnvironment();
+	return StepEventLoop(this, env, UV_RUN_NOWAIT) ? 1 : 0;
+}
+
+NODE_EXTERN void NodeEngine::SetRunLimits(unsigned int wall_ms, unsigned int cpu_ms)
+{
+	run_wall_limit = wall_ms;
+	run_cpu_limit = cpu_ms;
+}
+
+NODE_EXTERN void NodeEngine::Interrupt()
+{
+	//run can't finish, while its termination is requested (see RunScope)
+	std::lock_guard<std::mutex> lock(interrupt_mutex);
+	if (!node_started || !running)
+		return;
+	interrupted = true;
+	node_engine_isolate->TerminateExecution();
+	//loop can wait for events
+	uv_async_send(interrupt_async);
+}
+
 NODE_EXTERN void NodeEngine::StopScript()
 {
 	StopNodeInstance();
@@ -4712,7 +4987,7 @@ void NodeEngine::InitEngine(void * arg, void * eng)
 {
     using namespace Bv8;
     if (!node_engine_isolate) {
-        throw V8Exception();
+        THROW_V8_EXCEPTION();
     }
     {
         auto global = Local<ObjectTemplate>();
@@ -4736,6 +5011,16 @@ void NodeEngine::InitEngine(void * arg, void * eng)
     initialized = true;
 }
 
+NODE_EXTERN StartupData CreateStartupSnapshot(const char * source, const char * warmup_source)
+{
+	StartupData blob = V8::CreateSnapshotDataBlob(source);
+	if (!blob.data || !warmup_source)
+		return blob;
+	StartupData warm_blob = V8::WarmUpSnapshotDataBlob(blob, warmup_source);
+	delete[] blob.data;
+	return warm_blob;
+}
+
 NODE_EXTERN void Dispose()
 {
 	V8::Dispose();
@@ -42,6 +42,8 @@
 #include "v8.h"  // NOLINT(build/include_order)
 #include "node_version.h"  // NODE_MODULE_VERSION
 #include <functional>
+#include <atomic>
+#include <mutex>
 
 #define NODE_MAKE_VERSION(major, minor, patch)                                \
   ((major) * 0x1000 + (minor) * 0x100 + (patch))
@@ -181,7 +183,9 @@ namespace node {
 class V8Exception : public std::exception {
 };
 
-static std::function<void(int)> exit;
+// process.exit of engine, whose isolate is entered on current thread: code goes
+// to engine's exit callback (see NodeEngine::RunScript), without it process exits
+NODE_EXTERN void exit(int code);
 
 NODE_EXTERN extern bool no_deprecation;
 #if HAVE_OPENSSL && NODE_FIPS_MODE
@@ -193,6 +197,10 @@ NODE_EXTERN int Start(int argc, char *argv[], std::function<void(int)> func, voi
 /// splitted 'Start' method for using in Delphi;
 NODE_EXTERN void InitIalize(int argc, char *argv[]);
 NODE_EXTERN void Dispose();
+//makes startup snapshot with side effects of source (it has to be plain js, without node's
+//modules and bindings); if warmup_source is set, snapshot gets compiled code of it too.
+//returns { nullptr, 0 } on failure, caller owns data (delete[])
+NODE_EXTERN v8::StartupData CreateStartupSnapshot(const char * source, const char * warmup_source = nullptr);
 NODE_EXTERN void Init(int* argc,
                       const char** argv,
                       int* exec_argc,
@@ -207,18 +215,70 @@ public:
 	void * iso_data_wrapper_ptr;
 	////
 	NodeEngine();
+	//isolate is created from startup snapshot (see CreateStartupSnapshot), data is copied;
+	//heap limits are in MB, 0 keeps V8's default
+	NodeEngine(const char * snapshot_data, int snapshot_size,
+		int max_old_space_mb = 0, int max_semi_space_mb = 0);
 	~NodeEngine();
 	v8::Isolate * node_engine_isolate;
+	//every engine has its own event loop, so engines can run scripts on different threads
+	struct uv_loop_s * event_loop;
 
 	NODE_EXTERN void StartNodeInstance(void* arg, void* eng);
 	NODE_EXTERN void StopNodeInstance();
 	NODE_EXTERN int Start(int argc, char **argv, std::function<void(int)> func, void *eng = nullptr);
 	NODE_EXTERN int RunScript(int argc, char *argv[], std::function<void(int)> func, void *eng = nullptr);
 	NODE_EXTERN void StopScript();
+	//runs script in already started environment: bootstrap, args and module cache are kept
+	//from previous run, only entry script is evaluated in new module.
+	//returns -1 if environment isn't started (then script has to be run by RunScript)
+	NODE_EXTERN int RunScriptWarm(const char * name, const char * code, bool isFile, std::function<void(int)> func, void *eng = nullptr);
+	NODE_EXTERN bool IsStarted() { return node_started; };
+	//in step mode RunScript/RunScriptWarm return after script's first tick, and
+	//host runs event loop by RunFor/PumpOnce on engine's thread
+	NODE_EXTERN void SetStepMode(bool step) { step_mode = step; };
+	//runs event loop for ms at most; returns 1 if script has more work, 0 if loop is drained,
+	//-1 if there is no started script
+	NODE_EXTERN int RunFor(unsigned int ms);
+	//runs ready callbacks once without waiting; result is the same as RunFor's one
+	NODE_EXTERN int PumpOnce();
+	//limits of every call, which runs script (RunScript, RunScriptWarm, RunFor, PumpOnce):
+	//wall time and cpu time of engine's thread in ms, 0 - no limit. Script is interrupted,
+	//when one of them is over
+	NODE_EXTERN void SetRunLimits(unsigned int wall_ms, unsigned int cpu_ms);
+	//terminates running script and stops its event loop; it can be called from any thread.
+	//It does nothing, when no script runs (RunScript, RunScriptWarm, RunFor, PumpOnce).
+	//Interrupted environment isn't reused by RunScriptWarm
+	NODE_EXTERN void Interrupt();
+	NODE_EXTERN bool WasInterrupted() { return interrupted; };
 private:
+	friend class RunLimitScope;
+	friend class RunScope;
+	friend void exit(int code);
 	//initialize global object and context (only once) for this engine
 	void InitEngine(void* arg, void* eng);
-	bool node_started;
+	void CreateIsolate();
+	//read by Interrupt on other threads
+	std::atomic<bool> node_started{ false };
+	bool step_mode = false;
+	//gets code of process.exit of script, which was run last by this engine
+	std::function<void(int)> exit_callback;
+	std::atomic<bool> interrupted{ false };
+	//script runs, so Interrupt can target it (see RunScope in node.cc)
+	bool running = false;
+	std::mutex interrupt_mutex;
+	//wakes event loop on Interrupt
+	struct uv_async_s * interrupt_async;
+	unsigned int run_wall_limit = 0;
+	unsigned int run_cpu_limit = 0;
+	//see RunLimitScope in node.cc
+	bool run_limits_active = false;
+	uint64_t run_cpu_start = 0;
+	std::atomic<bool> cpu_check_pending{ false };
+	//isolate reads snapshot while creating contexts, so it lives as long as isolate
+	v8::StartupData snapshot_blob = { nullptr, 0 };
+	int max_old_space = 0;
+	int max_semi_space = 0;
 	bool initialized = false;
 };
 
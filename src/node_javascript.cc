@@ -12,12 +12,52 @@ using v8::NewStringType;
 using v8::Object;
 using v8::String;
 
-Local<String> MainSource(Environment* env) {
-  return String::NewFromUtf8(
+// Sources of natives are static data of the binary, so strings are made as
+// external ones over them and aren't copied into heap of every isolate.
+// Resource is deleted by V8 (default Dispose), when string is collected.
+class NativeOneByteResource : public String::ExternalOneByteStringResource {
+ public:
+  NativeOneByteResource(const void* data, size_t length)
+      : data_(static_cast<const char*>(data)), length_(length) {}
+  const char* data() const override { return data_; }
+  size_t length() const override { return length_; }
+
+ private:
+  const char* data_;
+  size_t length_;
+};
+
+class NativeTwoByteResource : public String::ExternalStringResource {
+ public:
+  NativeTwoByteResource(const void* data, size_t length)
+      : data_(static_cast<const uint16_t*>(data)), length_(length) {}
+  const uint16_t* data() const override { return data_; }
+  size_t length() const override { return length_; }
+
+ private:
+  const uint16_t* data_;
+  size_t length_;
+};
+
+static Local<String> NativeSource(Environment* env, const _native& native) {
+  if (native.one_byte) {
+    return String::NewExternalOneByte(
+        env->isolate(),
+        new NativeOneByteResource(native.source, native.source_len))
+            .ToLocalChecked();
+  }
+  return String::NewExternalTwoByte(
       env->isolate(),
-      reinterpret_cast<const char*>(internal_bootstrap_node_native),
-      NewStringType::kNormal,
-      sizeof(internal_bootstrap_node_native)).ToLocalChecked();
+      new NativeTwoByteResource(native.source, native.source_len))
+          .ToLocalChecked();
+}
+
+Local<String> MainSource(Environment* env) {
+  for (auto native : natives) {
+    if (native.source == internal_bootstrap_node_native)
+      return NativeSource(env, native);
+  }
+  UNREACHABLE();
 }
 
 void DefineJavaScript(Environment* env, Local<Object> target) {
@@ -26,11 +66,7 @@ void DefineJavaScript(Environment* env, Local<Object> target) {
   for (auto native : natives) {
     if (native.source != internal_bootstrap_node_native) {
       Local<String> name = String::NewFromUtf8(env->isolate(), native.name);
-      Local<String> source =
-          String::NewFromUtf8(
-              env->isolate(), reinterpret_cast<const char*>(native.source),
-              NewStringType::kNormal, native.source_len).ToLocalChecked();
-      target->Set(name, source);
+      target->Set(name, NativeSource(env, native));
     }
   }
 }
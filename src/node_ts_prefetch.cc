@@ -0,0 +1,183 @@
+#include "node.h"
+#include "node_internals.h"
+#include "v8.h"
+#include "env.h"
+#include "env-inl.h"
+#include "util.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace node {
+namespace ts_prefetch {
+
+using v8::Array;
+using v8::Context;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::HandleScope;
+using v8::Isolate;
+using v8::Local;
+using v8::Locker;
+using v8::Object;
+using v8::Script;
+using v8::String;
+using v8::TryCatch;
+using v8::Undefined;
+using v8::Value;
+
+// TypeScript files of module graph are transpiled by worker threads before
+// main thread requires them (see lib/internal/ts_prefetch.js). Every worker
+// has its own isolate with plain context, where bundled compiler is run;
+// ts.transpileModule doesn't need node there, server part of compiler only
+// takes 'crypto' module at load, so require is a stub.
+
+struct TranspileJob {
+  std::string source;
+  // JSON of ts.transpileModule options
+  std::string options;
+  std::string output;
+  bool done = false;
+};
+
+struct WorkerData {
+  uv_thread_t thread;
+  const std::string* compiler;
+  std::vector<TranspileJob>* jobs;
+  std::atomic<size_t>* next;
+};
+
+static const char kPrelude[] = "var require = function(id) { return {}; };";
+static const char kDriver[] =
+    "(function(source, options) {\n"
+    "  return ts.transpileModule(source, JSON.parse(options)).outputText;\n"
+    "})";
+
+
+static Local<String> ToV8String(Isolate* isolate, const std::string& str) {
+  return String::NewFromUtf8(isolate,
+                             str.data(),
+                             v8::NewStringType::kNormal,
+                             static_cast<int>(str.size())).ToLocalChecked();
+}
+
+
+static bool RunSource(Local<Context> context,
+                      Local<String> source,
+                      Local<Value>* result) {
+  Local<Script> script;
+  return Script::Compile(context, source).ToLocal(&script) &&
+         script->Run(context).ToLocal(result);
+}
+
+
+static void RunWorker(void* arg) {
+  WorkerData* data = static_cast<WorkerData*>(arg);
+  ArrayBufferAllocator allocator;
+  Isolate::CreateParams params;
+  params.array_buffer_allocator = &allocator;
+  Isolate* isolate = Isolate::New(params);
+  {
+    Locker locker(isolate);
+    Isolate::Scope isolate_scope(isolate);
+    HandleScope handle_scope(isolate);
+    Local<Context> context = Context::New(isolate);
+    Context::Scope context_scope(context);
+    TryCatch try_catch(isolate);
+
+    Local<Value> driver;
+    // if compiler can't be loaded, jobs are left for other workers
+    // (or for main thread, which transpiles files, not done here)
+    if (RunSource(context, OneByteString(isolate, kPrelude), &driver) &&
+        RunSource(context, ToV8String(isolate, *data->compiler), &driver) &&
+        RunSource(context, OneByteString(isolate, kDriver), &driver) &&
+        driver->IsFunction()) {
+      Local<Function> transpile = driver.As<Function>();
+      std::vector<TranspileJob>& jobs = *data->jobs;
+      for (size_t i = (*data->next)++; i < jobs.size(); i = (*data->next)++) {
+        HandleScope scope(isolate);
+        TranspileJob& job = jobs[i];
+        Local<Value> argv[] = {
+          ToV8String(isolate, job.source),
+          ToV8String(isolate, job.options)
+        };
+        Local<Value> output;
+        if (transpile->Call(context, Undefined(isolate), arraysize(argv), argv)
+                .ToLocal(&output) && output->IsString()) {
+          String::Utf8Value utf8(output);
+          job.output.assign(*utf8, utf8.length());
+          job.done = true;
+        }
+        try_catch.Reset();
+      }
+    }
+  }
+  isolate->Dispose();
+}
+
+
+// args: compilerSource, sources, options (JSON strings), threads
+// returns array of outputs, it has undefined for files, which weren't
+// transpiled. Main thread waits for workers.
+static void Transpile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  if (!args[0]->IsString() || !args[1]->IsArray() || !args[2]->IsArray())
+    return env->ThrowTypeError("compiler source, sources and options expected");
+
+  Local<Array> sources = args[1].As<Array>();
+  Local<Array> options = args[2].As<Array>();
+  if (sources->Length() != options->Length())
+    return env->ThrowTypeError("sources and options must have same length");
+
+  String::Utf8Value compiler_utf8(args[0]);
+  std::string compiler(*compiler_utf8, compiler_utf8.length());
+  std::vector<TranspileJob> jobs(sources->Length());
+  for (uint32_t i = 0; i < jobs.size(); i++) {
+    String::Utf8Value source(sources->Get(i));
+    String::Utf8Value option(options->Get(i));
+    jobs[i].source.assign(*source, source.length());
+    jobs[i].options.assign(*option, option.length());
+  }
+
+  size_t threads = args[3]->IsUint32() ? args[3]->Uint32Value() : 1;
+  if (threads > jobs.size())
+    threads = jobs.size();
+
+  std::atomic<size_t> next(0);
+  std::vector<WorkerData> workers(threads);
+  size_t started = 0;
+  for (WorkerData& worker : workers) {
+    worker.compiler = &compiler;
+    worker.jobs = &jobs;
+    worker.next = &next;
+    if (uv_thread_create(&worker.thread, RunWorker, &worker) != 0)
+      break;
+    started++;
+  }
+  for (size_t i = 0; i < started; i++)
+    uv_thread_join(&workers[i].thread);
+
+  Local<Array> result = Array::New(isolate, jobs.size());
+  for (uint32_t i = 0; i < jobs.size(); i++) {
+    if (jobs[i].done)
+      result->Set(i, ToV8String(isolate, jobs[i].output));
+  }
+  args.GetReturnValue().Set(result);
+}
+
+
+void Initialize(Local<Object> target,
+                Local<Value> unused,
+                Local<Context> context) {
+  Environment* env = Environment::GetCurrent(context);
+  env->SetMethod(target, "transpile", Transpile);
+}
+
+}  // namespace ts_prefetch
+}  // namespace node
+
+NODE_MODULE_CONTEXT_AWARE_BUILTIN(ts_prefetch, node::ts_prefetch::Initialize)
@@ -7,8 +7,27 @@
 namespace node {
 
 Watchdog::Watchdog(v8::Isolate* isolate, uint64_t ms) : isolate_(isolate),
+                                                        callback_(nullptr),
+                                                        data_(nullptr),
                                                         timed_out_(false),
                                                         destroyed_(false) {
+  Init(ms, 0);
+}
+
+
+Watchdog::Watchdog(v8::Isolate* isolate,
+                   uint64_t interval,
+                   Callback callback,
+                   void* data) : isolate_(isolate),
+                                 callback_(callback),
+                                 data_(data),
+                                 timed_out_(false),
+                                 destroyed_(false) {
+  Init(interval, interval);
+}
+
+
+void Watchdog::Init(uint64_t ms, uint64_t repeat) {
   int rc;
   loop_ = new uv_loop_t;
   CHECK(loop_);
@@ -21,7 +40,7 @@ Watchdog::Watchdog(v8::Isolate* isolate, uint64_t ms) : isolate_(isolate),
   rc = uv_timer_init(loop_, &timer_);
   CHECK_EQ(0, rc);
 
-  rc = uv_timer_start(&timer_, &Watchdog::Timer, ms, 0);
+  rc = uv_timer_start(&timer_, &Watchdog::Timer, ms, repeat);
   CHECK_EQ(0, rc);
 
   rc = uv_thread_create(&thread_, &Watchdog::Run, this);
@@ -82,6 +101,13 @@ void Watchdog::Async(uv_async_t* async) {
 
 void Watchdog::Timer(uv_timer_t* timer) {
   Watchdog* w = ContainerOf(&Watchdog::timer_, timer);
+  if (w->callback_ != nullptr) {
+    if (!w->callback_(w->data_))
+      return;
+    w->timed_out_ = true;
+    uv_stop(w->loop_);
+    return;
+  }
   w->timed_out_ = true;
   uv_stop(w->loop_);
   w->isolate()->TerminateExecution();
@@ -15,7 +15,13 @@ namespace node {
 
 class Watchdog {
  public:
+  // callback is called on watchdog's thread every interval ms until it
+  // returns true; isolate isn't terminated by such watchdog itself
+  typedef bool (*Callback)(void* data);
+
   explicit Watchdog(v8::Isolate* isolate, uint64_t ms);
+  Watchdog(v8::Isolate* isolate, uint64_t interval, Callback callback,
+           void* data);
   ~Watchdog();
 
   void Dispose();
@@ -23,6 +29,7 @@ class Watchdog {
   v8::Isolate* isolate() { return isolate_; }
   bool HasTimedOut() { return timed_out_; }
  private:
+  void Init(uint64_t ms, uint64_t repeat);
   void Destroy();
 
   static void Run(void* arg);
@@ -34,6 +41,8 @@ class Watchdog {
   uv_loop_t* loop_;
   uv_async_t async_;
   uv_timer_t timer_;
+  Callback callback_;
+  void* data_;
   bool timed_out_;
   bool destroyed_;
 };
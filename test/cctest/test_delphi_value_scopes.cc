@@ -0,0 +1,69 @@
+#include "delphi_intf.h"
+
+#include "gtest/gtest.h"
+
+// values, made for host between BeginValueScope and EndValueScope, are
+// released by EndValueScope, so count of values kept by engine doesn't grow
+// over host's calls
+
+static char* Str(const char* s) {
+  return const_cast<char*>(s);
+}
+
+class DelphiValueScopesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    engine = Bv8::Bazis::InitEngine(nullptr);
+    ASSERT_NE(nullptr, engine);
+    // isolate of engine is made by its first run
+    Bv8::IValue* result = engine->RunString(Str("0"), Str("cctest"), Str("."),
+                                            nullptr);
+    delete result;
+    ASSERT_EQ(0, engine->ErrorCode());
+  }
+
+  void TearDown() override {
+    if (engine)
+      engine->Delete();
+  }
+
+  Bv8::IEngine* engine = nullptr;
+};
+
+TEST_F(DelphiValueScopesTest, EndReleasesValues) {
+  int count = engine->ValueCount();
+  for (int round = 0; round < 100; round++) {
+    engine->BeginValueScope();
+    for (int i = 0; i < 100; i++) {
+      EXPECT_NE(nullptr, engine->NewString(Str("value")));
+      EXPECT_NE(nullptr, engine->NewNumber(i));
+    }
+    EXPECT_EQ(count + 200, engine->ValueCount());
+    engine->EndValueScope();
+    EXPECT_EQ(count, engine->ValueCount());
+  }
+}
+
+TEST_F(DelphiValueScopesTest, NestedScopes) {
+  int count = engine->ValueCount();
+  engine->BeginValueScope();
+  EXPECT_NE(nullptr, engine->NewString(Str("outer")));
+  engine->BeginValueScope();
+  engine->NewString(Str("inner"));
+  engine->NewInteger(1);
+  EXPECT_EQ(count + 3, engine->ValueCount());
+  engine->EndValueScope();
+  // values of outer scope stay alive until its end
+  EXPECT_EQ(count + 1, engine->ValueCount());
+  engine->EndValueScope();
+  EXPECT_EQ(count, engine->ValueCount());
+}
+
+TEST_F(DelphiValueScopesTest, UnmatchedEndIsIgnored) {
+  int count = engine->ValueCount();
+  engine->EndValueScope();
+  EXPECT_EQ(count, engine->ValueCount());
+  // values out of scopes are kept by engine
+  engine->NewString(Str("kept"));
+  EXPECT_EQ(count + 1, engine->ValueCount());
+}
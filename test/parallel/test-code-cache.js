@@ -0,0 +1,64 @@
+'use strict';
+
+// Flags: --expose-internals
+
+const common = require('../common');
+if (!common.hasCrypto) {
+  common.skip('missing crypto');
+  return;
+}
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const codeCache = require('internal/code_cache');
+
+const stats = codeCache.stats;
+// sources shorter than 1024 chars aren't cached
+const source = 'var x = 40;\n'.repeat(100) + 'x + 2;';
+
+function cacheFiles() {
+  return fs.readdirSync(common.tmpDir);
+}
+
+common.refreshTmpDir();
+process._codeCacheDir = common.tmpDir;
+
+// first compilation makes cache file, no temp files are left
+assert.strictEqual(codeCache.runInThisContext(source, { filename: 'a.js' }),
+                   42);
+assert.deepStrictEqual(stats, { hits: 0, misses: 1, rejects: 0 });
+const files = cacheFiles();
+assert.strictEqual(files.length, 1);
+assert(/^[0-9a-f]{40}\.v8cache$/.test(files[0]), files[0]);
+const file = path.join(common.tmpDir, files[0]);
+
+// next one uses it
+assert.strictEqual(codeCache.runInThisContext(source, { filename: 'b.js' }),
+                   42);
+assert.deepStrictEqual(stats, { hits: 1, misses: 1, rejects: 0 });
+
+// data rejected by V8 is removed and made again by next compilation
+fs.writeFileSync(file, Buffer.from('not a code cache'));
+assert.strictEqual(codeCache.runInThisContext(source, { filename: 'c.js' }),
+                   42);
+assert.deepStrictEqual(stats, { hits: 1, misses: 1, rejects: 1 });
+assert.deepStrictEqual(cacheFiles(), []);
+codeCache.compile(source, { filename: 'd.js' });
+assert.deepStrictEqual(stats, { hits: 1, misses: 2, rejects: 1 });
+assert.deepStrictEqual(cacheFiles(), files);
+
+// key is cacheKey instead of source, when it is set
+codeCache.compile(source, { filename: 'e.js' }, 'built-in e');
+assert.deepStrictEqual(stats, { hits: 1, misses: 3, rejects: 1 });
+assert.strictEqual(cacheFiles().length, 2);
+
+// short sources aren't cached
+assert.strictEqual(codeCache.runInThisContext('1 + 1'), 2);
+assert.deepStrictEqual(stats, { hits: 1, misses: 3, rejects: 1 });
+assert.strictEqual(cacheFiles().length, 2);
+
+// cache is off without directory
+process._codeCacheDir = undefined;
+assert.strictEqual(codeCache.runInThisContext(source, { filename: 'f.js' }),
+                   42);
+assert.deepStrictEqual(stats, { hits: 1, misses: 3, rejects: 1 });
@@ -0,0 +1,69 @@
+'use strict';
+
+// Flags: --expose-internals
+
+const common = require('../common');
+if (!common.hasCrypto) {
+  common.skip('missing crypto');
+  return;
+}
+const assert = require('assert');
+const fs = require('fs');
+const tsCache = require('internal/ts_cache');
+const ts = require('tsserverlibrary');
+
+const stats = tsCache.stats;
+const source = 'export const answer: number = 42;\n';
+const options = tsCache.moduleOptions('/modules/a.ts');
+
+common.refreshTmpDir();
+
+// output is the one of ts.transpileModule
+const first = tsCache.transpile(source, '/modules/a.ts', options);
+assert.strictEqual(first.cached, false);
+assert.strictEqual(first.outputText,
+                   ts.transpileModule(source, options).outputText);
+assert.strictEqual(stats.misses, 1);
+
+const second = tsCache.transpile(source, '/modules/a.ts', options);
+assert.strictEqual(second.cached, true);
+assert.strictEqual(second.outputText, first.outputText);
+assert.strictEqual(stats.hits, 1);
+assert(tsCache.has(source, '/modules/a.ts', options));
+
+// file name and options are parts of key
+assert.strictEqual(
+    tsCache.transpile(source, '/modules/b.ts', options).cached, false);
+const es6Options = tsCache.moduleOptions('/modules/a.ts');
+es6Options.compilerOptions.target = 'es6';
+assert.strictEqual(
+    tsCache.transpile(source, '/modules/a.ts', es6Options).cached, false);
+assert.strictEqual(stats.misses, 3);
+
+// output goes to disk, when directory is set; no temp files are left
+process._tsCacheDir = common.tmpDir;
+const diskSource = 'export const onDisk = true;\n';
+const output = tsCache.transpile(diskSource, '/modules/c.ts', options);
+const files = fs.readdirSync(common.tmpDir);
+assert.strictEqual(files.length, 1);
+assert(/^[0-9a-f]{40}\.js$/.test(files[0]), files[0]);
+
+// memory cache keeps only recently used outputs, evicted ones are read
+// from disk
+process._tsCacheDir = undefined;
+for (var i = 0; i < 512; i++)
+  tsCache.transpile(`export const v = ${i};\n`, '/modules/v.ts', options);
+assert.strictEqual(tsCache.has(diskSource, '/modules/c.ts', options), false);
+process._tsCacheDir = common.tmpDir;
+const diskHits = stats.diskHits;
+const fromDisk = tsCache.transpile(diskSource, '/modules/c.ts', options);
+assert.strictEqual(fromDisk.cached, true);
+assert.strictEqual(fromDisk.outputText, output.outputText);
+assert.strictEqual(stats.diskHits, diskHits + 1);
+
+// output, transpiled elsewhere, is stored by its source
+tsCache.store('let stored;\n', '/modules/d.ts', options, 'var stored;\n');
+assert.deepStrictEqual(tsCache.transpile('let stored;\n', '/modules/d.ts',
+                                         options),
+                       { outputText: 'var stored;\n', cached: true });
+process._tsCacheDir = undefined;
@@ -0,0 +1,68 @@
+'use strict';
+
+// Flags: --expose-internals
+
+const common = require('../common');
+if (!common.hasCrypto) {
+  common.skip('missing crypto');
+  return;
+}
+const assert = require('assert');
+const fs = require('fs');
+const path = require('path');
+const tsCache = require('internal/ts_cache');
+const tsPrefetch = require('internal/ts_prefetch');
+const ts = require('tsserverlibrary');
+
+const stats = tsCache.stats;
+
+// module graph: m0 imports m1 and m2, m1 imports m3 and m4 and so on
+function makeGraph(dir, modules) {
+  fs.mkdirSync(dir);
+  const files = [];
+  for (var i = 0; i < modules; i++) {
+    const deps = [];
+    for (var j = 2 * i + 1; j <= 2 * i + 2 && j < modules; j++)
+      deps.push(`import { v${j} } from './m${j}';`);
+    const file = path.join(dir, `m${i}.ts`);
+    fs.writeFileSync(file, deps.join('\n') + `
+interface Point${i} { x: number; y: number; }
+export const v${i}: Point${i} = { x: ${i}, y: ${i} };
+`);
+    files.push(file);
+  }
+  return files;
+}
+
+common.refreshTmpDir();
+
+// outputs of workers are the ones of main thread's ts.transpileModule
+const files = makeGraph(path.join(common.tmpDir, 'graph'), 12);
+// file, which isn't reachable from entry module, isn't transpiled
+const unreachable = path.join(common.tmpDir, 'graph', 'unreachable.ts');
+fs.writeFileSync(unreachable, 'export const u: number = 0;\n');
+
+assert.strictEqual(tsPrefetch.prefetch(files[0], 2), files.length);
+assert.strictEqual(stats.prefetchedFiles, files.length);
+assert.strictEqual(stats.prefetchThreads, 2);
+const misses = stats.misses;
+for (const file of files) {
+  const source = fs.readFileSync(file, 'utf8');
+  const options = tsCache.moduleOptions(file);
+  const result = tsCache.transpile(source, file, options);
+  assert.strictEqual(result.cached, true, file);
+  assert.strictEqual(result.outputText,
+                     ts.transpileModule(source, options).outputText, file);
+}
+assert.strictEqual(stats.misses, misses);
+const unreachableSource = fs.readFileSync(unreachable, 'utf8');
+assert.strictEqual(tsCache.has(unreachableSource, unreachable,
+                               tsCache.moduleOptions(unreachable)), false);
+
+// cached files aren't transpiled again
+assert.strictEqual(tsPrefetch.prefetch(files[0], 2), 0);
+
+// small graph isn't worth of loading compiler by worker
+const small = makeGraph(path.join(common.tmpDir, 'small'), 4);
+assert.strictEqual(tsPrefetch.prefetch(small[0], 2), 0);
+assert.strictEqual(stats.prefetchedFiles, files.length);
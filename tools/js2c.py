@@ -33,12 +33,26 @@
 
 import os
 import re
+import struct
 import sys
 import string
 
 
-def ToCArray(filename, lines):
-  return ','.join(str(ord(c)) for c in lines)
+def ToCArray(elements):
+  return ','.join(str(e) for e in elements)
+
+
+def ToCharacters(lines):
+  # Sources are emitted as characters, not as UTF-8 bytes, so node can make
+  # external strings over them: Latin-1 sources as one-byte arrays, others
+  # as UTF-16 code units.
+  if isinstance(lines, bytes):
+    lines = lines.decode('utf-8')
+  if all(ord(c) < 256 for c in lines):
+    return ('uint8_t', [ord(c) for c in lines])
+  encoded = lines.encode('utf-16-le')
+  units = struct.unpack('<%dH' % (len(encoded) // 2), encoded)
+  return ('uint16_t', units)
 
 
 def ReadFile(filename):
@@ -176,14 +190,18 @@ def ReadMacros(lines):
 HEADER_TEMPLATE = """\
 #ifndef node_natives_h
 #define node_natives_h
+#include <stdint.h>
 namespace node {
 
 %(source_lines)s\
 
 struct _native {
   const char* name;
-  const unsigned char* source;
+  // uint8_t (Latin-1) or uint16_t (UTF-16) characters
+  const void* source;
+  // in characters
   size_t source_len;
+  bool one_byte;
 };
 
 static const struct _native natives[] = { %(native_lines)s };
@@ -194,11 +212,13 @@ static const struct _native natives[] = { %(native_lines)s };
 
 
 NATIVE_DECLARATION = """\
-  { "%(id)s", %(escaped_id)s_native, sizeof(%(escaped_id)s_native) },
+  { "%(id)s", %(escaped_id)s_native,
+    sizeof(%(escaped_id)s_native) / sizeof(%(escaped_id)s_native[0]),
+    %(one_byte)s },
 """
 
 SOURCE_DECLARATION = """\
-  const unsigned char %(escaped_id)s_native[] = { %(data)s };
+  const %(type)s %(escaped_id)s_native[] = { %(data)s };
 """
 
 
@@ -246,7 +266,8 @@ def JS2C(source, target):
 
     lines = ExpandConstants(lines, consts)
     lines = ExpandMacros(lines, macros)
-    data = ToCArray(s, lines)
+    (type, characters) = ToCharacters(lines)
+    data = ToCArray(characters)
 
     # On Windows, "./foo.bar" in the .gyp file is passed as "foo.bar"
     # so don't assume there is always a slash in the file path.
@@ -268,16 +289,19 @@ def JS2C(source, target):
     source_lines.append(SOURCE_DECLARATION % {
       'id': id,
       'escaped_id': escaped_id,
+      'type': type,
       'data': data
     })
     source_lines_empty.append(SOURCE_DECLARATION % {
       'id': id,
       'escaped_id': escaped_id,
+      'type': 'uint8_t',
       'data': 0
     })
     native_lines.append(NATIVE_DECLARATION % {
       'id': id,
-      'escaped_id': escaped_id
+      'escaped_id': escaped_id,
+      'one_byte': 'true' if type == 'uint8_t' else 'false'
     })
 
   # Build delay support functions